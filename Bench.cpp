@@ -0,0 +1,316 @@
+/***********************************************************************
+* Bench.cpp Implementation of micro-benchmarks for chess simulation    *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#include "Bitboard.h"
+#include "ChessBoard.h"
+#include "NNUE.h"
+#include "Search.h"
+#include "TransTable.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+const char* USAGE = ""
+    "Usage:\n"
+    "\n"
+    " - bench:                           Run all benchmarks.\n"
+    "\n"
+    " - bench <NAME> ...:                Run the named benchmarks, one of the following:\n"
+    "                                    sliders - rook and bishop attacks by board walking, rays and lookup tables.\n"
+    "                                    nnue - network evaluations from scratch and by accumulator updates.\n"
+    "                                    search - nodes searched to a fixed depth on a set of positions.\n";
+
+// Number of random occupancies each benchmark runs through.
+const int SAMPLE_NUM = 4096;
+
+// Number of random games and their length in plies, for the network benchmark.
+const int GAME_NUM = 64, GAME_PLY = 80;
+
+// Positions and depths of the search benchmark.
+const char* SEARCH_FEN[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/3P1N2/PPP2PPP/RNBQK2R w KQkq - 1 5",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1b2rk1/2q1bppp/p2p1n2/np2p3/3PP3/5N1P/PPBN1PP1/R1BQR1K1 w - - 0 13",
+};
+const int SEARCH_DEPTH = 7;
+
+// An output stream writing nowhere, for the boards.
+ostream null_stream(nullptr);
+
+// Row and column steps of the straight and the diagonal directions.
+const int STEP[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+/**
+ * Generate random occupancies with a fixed seed, a quarter of the squares occupied on average.
+ * @return The occupancies.
+ */
+vector<bitboard> randomOccupancies()
+{
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    vector<bitboard> res;
+    for (int i = 0; i < SAMPLE_NUM; i++)
+    {
+        bitboard b = ~(bitboard) 0;
+        for (int k = 0; k < 2; k++)
+        {
+            seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+            b &= seed * 0x2545f4914f6cdd1dULL;
+        }
+        res.push_back(b);
+    }
+    return res;
+}
+
+/**
+ * Get the squares attacked by a slider by walking the board grid by grid, as the pieces did before the tables.
+ * @param sq: The square of the slider.
+ * @param occupied: Occupied squares.
+ * @param begin: First direction.
+ * @param end: One past the last direction.
+ * @return The bitboard.
+ */
+bitboard walkAttack(int sq, bitboard occupied, int begin, int end)
+{
+    bitboard res = 0;
+    for (int i = begin; i < end; i++)
+    {
+        int r = (sq >> 3) + STEP[i][0], c = (sq & 7) + STEP[i][1];
+        for (; 0 <= r && r < 8 && 0 <= c && c < 8; r += STEP[i][0], c += STEP[i][1])
+        {
+            bitboard bit = squareBit(coordSquare(make_pair(r, c)));
+            res |= bit;
+            if (occupied & bit)
+                break;
+        }
+    }
+    return res;
+}
+
+/**
+ * Time one way of getting the rook and bishop attacks of every square under every occupancy.
+ * @param name: Name of the way.
+ * @param occupancies: The occupancies.
+ * @param way: 0 for walking, 1 for rays and 2 for the lookup tables.
+ * @return Checksum of all attack sets, the same for every way.
+ */
+uint64_t timeSliders(const char* name, const vector<bitboard>& occupancies, int way)
+{
+    typedef chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    uint64_t sum = 0;
+    for (bitboard occupied: occupancies)
+        for (int sq = 0; sq < 64; sq++)
+        {
+            if (way == 0)
+                sum += walkAttack(sq, occupied, 0, 4) ^ walkAttack(sq, occupied, 4, 8);
+            else if (way == 1)
+                sum += rookRayAttack(sq, occupied) ^ bishopRayAttack(sq, occupied);
+            else
+                sum += rookAttack(sq, occupied) ^ bishopAttack(sq, occupied);
+        }
+    double seconds = chrono::duration<double>(clock::now() - start).count();
+    cout << "  " << name << ": " << seconds * 1e9 / (occupancies.size() * 64) << " ns per square, checksum " << sum << '\n';
+    return sum;
+}
+
+/**
+ * Compare the ways of getting sliding attacks.
+ * @return If all ways agree.
+ */
+bool benchSliders()
+{
+    cout << "Sliders (a rook and a bishop attack per square)" << endl;
+    vector<bitboard> occupancies = randomOccupancies();
+    uint64_t walk = timeSliders("Board walking", occupancies, 0);
+    bool ok = timeSliders("Ray tables   ", occupancies, 1) == walk;
+
+    string name = string("Lookup, ") + SLIDER_INDEX;
+    ok = timeSliders((name + string(13 - name.size(), ' ')).c_str(), occupancies, 2) == walk && ok;
+    return ok;
+}
+
+/**
+ * Play random games with a fixed seed, stopping early at the end of a game.
+ * @return The moves of each game.
+ */
+vector<vector<Move>> randomGames()
+{
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    vector<vector<Move>> res(GAME_NUM);
+    ChessBoard board(null_stream);
+    MoveList list;
+    for (vector<Move>& game: res)
+    {
+        board.resetBoard();
+        for (int ply = 0; ply < GAME_PLY; ply++)
+        {
+            board.generateLegalMoves(list);
+            if (!list.size())
+                break;
+            seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+            game.push_back(list[(seed * 0x2545f4914f6cdd1dULL >> 32) % list.size()]);
+            board.makeMove(game.back());
+        }
+    }
+    return res;
+}
+
+/**
+ * Time evaluating every position of the games by a network.
+ * @param network: The network.
+ * @param games: The games.
+ * @param incremental: Whether the accumulator is updated along the moves, or computed from scratch for each position.
+ * @return Checksum of all evaluations, the same for every way and instruction set.
+ */
+int64_t timeNetwork(const NNUE& network, const vector<vector<Move>>& games, bool incremental)
+{
+    ChessBoard board(null_stream);
+    Accumulator acc, next;
+    int64_t sum = 0, evals = 0;
+
+    typedef chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    for (const vector<Move>& game: games)
+    {
+        board.resetBoard();
+        if (incremental)
+            network.refresh(acc, board.getPosition().squares);
+        for (Move move: game)
+        {
+            int score;
+            if (incremental)
+            {
+                network.applyMove(acc, next, board, move);
+                board.makeMove(move);
+                score = network.evaluate(next, board.getSide());
+                swap(acc, next);
+            }
+            else
+            {
+                board.makeMove(move);
+                Position position = board.getPosition();
+                network.refresh(acc, position.squares);
+                score = network.evaluate(acc, position.side);
+            }
+            sum += board.getSide() == ChessBoard::WHITE ? score : -score;
+            evals++;
+        }
+    }
+    double seconds = chrono::duration<double>(clock::now() - start).count();
+    string name = string(NNUE::SIMD_NAME[network.getSimd()]) + (incremental ? " updated" : " from scratch");
+    cout << "  " << name << string(20 - name.size(), ' ') << ": " << (uint64_t) (evals / seconds) << " evals/s, ";
+    cout << "checksum " << sum << '\n';
+    return sum;
+}
+
+/**
+ * Compare the ways and instruction sets of evaluating by a network with random weights.
+ * @return If all ways agree.
+ */
+bool benchNnue()
+{
+    cout << "NNUE (768 -> 2 x 256 -> 32 -> 1, random weights, including the moves made)" << endl;
+    vector<vector<Move>> games = randomGames();
+    NNUE network;
+    network.randomize(0x2545f4914f6cdd1dULL);
+    int best = network.getSimd();
+
+    bool ok = true;
+    int64_t reference = 0;
+    for (int simd = NNUE::SCALAR; simd <= NNUE::AVX2; simd++)
+    {
+        if (!network.setSimd(simd))
+        {
+            cout << "  " << NNUE::SIMD_NAME[simd] << ": not supported by the CPU" << endl;
+            continue;
+        }
+        int64_t sum = timeNetwork(network, games, false);
+        if (simd == NNUE::SCALAR)
+            reference = sum;
+        ok = sum == reference && timeNetwork(network, games, true) == reference && ok;
+    }
+    network.setSimd(best);
+    cout << "  In use: " << NNUE::SIMD_NAME[best] << endl;
+    return ok;
+}
+
+/**
+ * Search each position of the set to a fixed depth on one thread, with a fresh transposition table.
+ * @return Always true, as there is nothing to compare.
+ */
+bool benchSearch()
+{
+    cout << "Search (depth " << SEARCH_DEPTH << ", one thread, " << TransTable::DEFAULT_SIZE << " MB table)" << endl;
+    ChessBoard board(null_stream);
+    TransTable table;
+    uint64_t total = 0;
+    double total_seconds = 0;
+    for (const char* fen: SEARCH_FEN)
+    {
+        board.setFEN(fen);
+        table.clear();
+        Search search(board, &table, null_stream);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Move move = search.think(SEARCH_DEPTH);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "  " << move.str() << ' ' << search.getNodes() << " nodes, " << seconds << " s  " << fen << '\n';
+        total += search.getNodes();
+        total_seconds += seconds;
+    }
+    cout << "  Total: " << total << " nodes, " << total_seconds << " s, " << (uint64_t) (total / total_seconds);
+    cout << " nodes/s" << endl;
+    return true;
+}
+
+/*
+ * Micro-benchmarks of the building blocks of the chess simulation.
+ */
+int main(int argc, char* argv[])
+{
+    // Run all benchmarks if none is named.
+    vector<string> names(argv + 1, argv + argc);
+    if (names.empty())
+        names = {"sliders", "nnue", "search"};
+
+    bool ok = true;
+    for (const string& name: names)
+    {
+        if (name == "sliders")
+            ok = benchSliders() && ok;
+        else if (name == "nnue")
+            ok = benchNnue() && ok;
+        else if (name == "search")
+            ok = benchSearch() && ok;
+        else
+        {
+            cout << USAGE;
+            return 1;
+        }
+        cout << endl;
+    }
+
+    cout << (ok ? "All results agree" : "Some results DIFFER") << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/***********************************************************************
+* Bitboard.cpp Implementation of attack tables for chess simulation    *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#include "Bitboard.h"
+
+#include <cstring>
+
+using namespace std;
+
+
+// Row and column steps of the eight directions, in the order of RAY.
+static const int DIRECTION[DIRECTION_NUM][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+// Row and column steps of a knight.
+static const int KNIGHT_STEP[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+
+bitboard KNIGHT_ATTACK[64];
+bitboard KING_ATTACK[64];
+bitboard PAWN_ATTACK[2][64];
+bitboard RAY[DIRECTION_NUM][64];
+bitboard BETWEEN[64][64];
+bitboard LINE[64][64];
+Magic ROOK_MAGIC[64];
+Magic BISHOP_MAGIC[64];
+#ifdef __BMI2__
+const char* SLIDER_INDEX = "PEXT";
+#else
+const char* SLIDER_INDEX = "Magic";
+#endif
+
+// Attack sets of all squares, the sum of 2 ^ (number of mask squares) over the board.
+static bitboard ROOK_TABLE[0x19000];
+static bitboard BISHOP_TABLE[0x1480];
+
+/**
+ * Get the bitboard of a grid, if it is on the board.
+ * @param r: Row.
+ * @param c: Column.
+ * @return The bitboard, empty if the grid is off the board.
+ */
+static bitboard gridBit(int r, int c)
+{
+    return 0 <= r && r < 8 && 0 <= c && c < 8 ? squareBit(coordSquare(make_pair(r, c))) : 0;
+}
+
+/**
+ * Build the attack lookups of a slider on every square.
+ * @param magics: The lookups.
+ * @param table: Where the attack sets of all squares are stored.
+ * @param attack: The function getting the attack set by walking the rays.
+ */
+static void initSlider(Magic* magics, bitboard* table, bitboard (*attack)(int, bitboard))
+{
+    static bitboard occupancy[4096], reference[4096];
+    bitboard* attacks = table;
+#ifndef __BMI2__
+    // The entries written by each try are marked with its count, which restarts at every call, and so do the marks.
+    static int epoch[4096];
+    int count = 0;
+    memset(epoch, 0, sizeof(epoch));
+    // A fixed seed, so that the same magic numbers are found in every run.
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+#endif
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        // The edges do not block anything, unless the slider is on the edge itself.
+        Magic& m = magics[sq];
+        bitboard rows = 0xff000000000000ffULL & ~(0xffULL << (sq & ~7));
+        bitboard cols = 0x8181818181818181ULL & ~(0x0101010101010101ULL << (sq & 7));
+        m.mask = attack(sq, 0) & ~(rows | cols);
+        m.shift = 64 - popCount(m.mask);
+        m.magic = 0;
+        m.attacks = attacks;
+
+        // Enumerate every subset of the mask, with its attack set.
+        int size = 0;
+        bitboard b = 0;
+        do
+        {
+            occupancy[size] = b;
+            reference[size++] = attack(sq, b);
+            b = (b - m.mask) & m.mask;
+        } while (b);
+        attacks += size;
+
+#ifdef __BMI2__
+        for (int i = 0; i < size; i++)
+            m.attacks[slidingIndex(m, occupancy[i])] = reference[i];
+#else
+        // Try sparse random numbers until one maps every subset to an index without a conflicting attack set.
+        for (int i = 0; i < size; )
+        {
+            do
+            {
+                uint64_t r[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+                    r[k] = seed * 0x2545f4914f6cdd1dULL;
+                }
+                m.magic = r[0] & r[1] & r[2];
+            } while (popCount((m.magic * m.mask) >> 56) < 6);
+
+            for (count++, i = 0; i < size; i++)
+            {
+                size_t index = (occupancy[i] * m.magic) >> m.shift;
+                if (epoch[index] < count)
+                {
+                    epoch[index] = count;
+                    m.attacks[index] = reference[i];
+                }
+                else if (m.attacks[index] != reference[i])
+                    break;
+            }
+        }
+#endif
+    }
+}
+
+/*
+ * The tables are built by walking the board once at startup, so that no piece walks it again while playing.
+ */
+static struct AttackInit
+{
+    AttackInit()
+    {
+        for (int sq = 0; sq < 64; sq++)
+        {
+            int r = sq >> 3, c = sq & 7;
+            for (int i = 0; i < 8; i++)
+            {
+                KNIGHT_ATTACK[sq] |= gridBit(r + KNIGHT_STEP[i][0], c + KNIGHT_STEP[i][1]);
+                KING_ATTACK[sq] |= gridBit(r + DIRECTION[i][0], c + DIRECTION[i][1]);
+            }
+            PAWN_ATTACK[0][sq] = gridBit(r + 1, c - 1) | gridBit(r + 1, c + 1);
+            PAWN_ATTACK[1][sq] = gridBit(r - 1, c - 1) | gridBit(r - 1, c + 1);
+
+            // Walk each direction to the edge, the squares passed are between the square and each step.
+            for (int dir = 0; dir < DIRECTION_NUM; dir++)
+            {
+                bitboard path = 0;
+                for (int nr = r + DIRECTION[dir][0], nc = c + DIRECTION[dir][1]; gridBit(nr, nc);
+                     nr += DIRECTION[dir][0], nc += DIRECTION[dir][1])
+                {
+                    BETWEEN[sq][coordSquare(make_pair(nr, nc))] = path;
+                    path |= gridBit(nr, nc);
+                }
+                RAY[dir][sq] = path;
+            }
+        }
+
+        // A line is made up of the rays on both sides of a square, with the square itself.
+        // Straight directions come in opposite pairs (N, S) and (E, W), diagonal ones are NE, NW, SE, SW.
+        for (int sq = 0; sq < 64; sq++)
+            for (int dir = 0; dir < DIRECTION_NUM; dir++)
+            {
+                int opposite = dir < 4 ? dir ^ 1 : 11 - dir;
+                bitboard line = RAY[dir][sq] | RAY[opposite][sq] | squareBit(sq), ray = RAY[dir][sq];
+                while (ray)
+                    LINE[sq][popLsb(ray)] = line;
+            }
+
+        // The sliding attacks are looked up by magic numbers, or by PEXT where BMI2 is enabled at compile time.
+        initSlider(ROOK_MAGIC, ROOK_TABLE, rookRayAttack);
+        initSlider(BISHOP_MAGIC, BISHOP_TABLE, bishopRayAttack);
+    }
+} ATTACK_INIT;
@@ -0,0 +1,219 @@
+/***********************************************************************
+* Bitboard.h Declaration of bitboard helpers for chess simulation      *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#ifndef _BITBOARD_H_
+#define _BITBOARD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// Using pair<int, int> to represent a coordinate.
+typedef std::pair<int, int> coord;
+
+// Using a 64-bit integer to represent a set of squares, bit (row * 8 + column) for each square.
+typedef uint64_t bitboard;
+
+/**
+ * Transfer a coordinate into a square index.
+ * @param pos: A valid coordinate.
+ * @return The square index, A1 = 0, B1 = 1, ..., H8 = 63.
+ */
+inline int coordSquare(const coord& pos)
+{
+    return pos.first * 8 + pos.second;
+}
+
+/**
+ * Transfer a square index back into a coordinate.
+ * @param sq: A square index.
+ * @return The coordinate.
+ */
+inline coord squareCoord(int sq)
+{
+    return std::make_pair(sq >> 3, sq & 7);
+}
+
+/**
+ * Get the bitboard with only one square set.
+ * @param sq: A square index.
+ * @return The bitboard.
+ */
+inline bitboard squareBit(int sq)
+{
+    return (bitboard) 1 << sq;
+}
+
+/**
+ * Get the index of the least significant square in a bitboard.
+ * @param b: A non-empty bitboard.
+ * @return The square index.
+ */
+inline int lsb(bitboard b)
+{
+    return __builtin_ctzll(b);
+}
+
+/**
+ * Remove the least significant square from a bitboard and return it.
+ * @param b: A non-empty bitboard.
+ * @return The removed square index.
+ */
+inline int popLsb(bitboard& b)
+{
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+/**
+ * Get the index of the most significant square in a bitboard.
+ * @param b: A non-empty bitboard.
+ * @return The square index.
+ */
+inline int msb(bitboard b)
+{
+    return 63 - __builtin_clzll(b);
+}
+
+/**
+ * Count the squares in a bitboard.
+ * @param b: A bitboard.
+ * @return Number of squares set.
+ */
+inline int popCount(bitboard b)
+{
+    return __builtin_popcountll(b);
+}
+
+// Number of directions, the first four are straight (N, S, E, W) and the last four are diagonal (NE, NW, SE, SW).
+const int DIRECTION_NUM = 8;
+
+// Attack tables, built once before main by Bitboard.cpp, indexed by squares.
+// Squares attacked by a knight, a king and a pawn of each side.
+extern bitboard KNIGHT_ATTACK[64];
+extern bitboard KING_ATTACK[64];
+extern bitboard PAWN_ATTACK[2][64];
+// Squares on a direction from a square to the edge, the square itself excluded.
+extern bitboard RAY[DIRECTION_NUM][64];
+// Squares strictly between two squares on a same row, column or diagonal, empty if they are not aligned.
+extern bitboard BETWEEN[64][64];
+// The whole row, column or diagonal through two squares, empty if they are not aligned.
+extern bitboard LINE[64][64];
+
+/**
+ * Get the squares attacked along a direction, up to and including the first occupied square.
+ * @param dir: The direction.
+ * @param sq: The square the attack comes from.
+ * @param occupied: Occupied squares.
+ * @return The bitboard.
+ */
+inline bitboard rayAttack(int dir, int sq, bitboard occupied)
+{
+    // North, east, north-east and north-west go toward higher squares, so the nearest blocker is the lowest one.
+    bitboard ray = RAY[dir][sq], blockers = ray & occupied;
+    if (blockers)
+        ray ^= RAY[dir][(0x35 >> dir) & 1 ? lsb(blockers) : msb(blockers)];
+    return ray;
+}
+
+/**
+ * Get the squares attacked by a rook by walking the rays, which is used to build the sliding attack tables.
+ * @param sq: The square of the rook.
+ * @param occupied: Occupied squares.
+ * @return The bitboard.
+ */
+inline bitboard rookRayAttack(int sq, bitboard occupied)
+{
+    return rayAttack(0, sq, occupied) | rayAttack(1, sq, occupied) | rayAttack(2, sq, occupied) |
+        rayAttack(3, sq, occupied);
+}
+
+/**
+ * Get the squares attacked by a bishop by walking the rays, which is used to build the sliding attack tables.
+ * @param sq: The square of the bishop.
+ * @param occupied: Occupied squares.
+ * @return The bitboard.
+ */
+inline bitboard bishopRayAttack(int sq, bitboard occupied)
+{
+    return rayAttack(4, sq, occupied) | rayAttack(5, sq, occupied) | rayAttack(6, sq, occupied) |
+        rayAttack(7, sq, occupied);
+}
+
+/**
+ * Sliding attack lookup of a square for a rook or a bishop.
+ * The occupied squares which matter (the mask) are turned into an index of the attack sets of the square,
+ * by a multiplication with a magic number, or by PEXT if BMI2 is enabled at compile time (e.g. by -mbmi2).
+ */
+struct Magic
+{
+    // Squares which may block the slider, the edges excluded.
+    bitboard mask;
+    // The magic number, and the shift leaving the index.
+    bitboard magic;
+    int shift;
+    // Attack sets of the square.
+    bitboard* attacks;
+};
+
+// Sliding attack lookups of each square.
+extern Magic ROOK_MAGIC[64];
+extern Magic BISHOP_MAGIC[64];
+// Name of the index of the lookups, "PEXT" or "Magic".
+extern const char* SLIDER_INDEX;
+
+/**
+ * Get the index of the attack set of a slider.
+ * The way is fixed at compile time, so that no lookup takes a branch or a call to pick it.
+ * @param m: The lookup of the square.
+ * @param occupied: Occupied squares.
+ * @return The index.
+ */
+inline size_t slidingIndex(const Magic& m, bitboard occupied)
+{
+#ifdef __BMI2__
+    return _pext_u64(occupied, m.mask);
+#else
+    return ((occupied & m.mask) * m.magic) >> m.shift;
+#endif
+}
+
+/**
+ * Get the squares attacked by a rook.
+ * @param sq: The square of the rook.
+ * @param occupied: Occupied squares.
+ * @return The bitboard.
+ */
+inline bitboard rookAttack(int sq, bitboard occupied)
+{
+    return ROOK_MAGIC[sq].attacks[slidingIndex(ROOK_MAGIC[sq], occupied)];
+}
+
+/**
+ * Get the squares attacked by a bishop.
+ * @param sq: The square of the bishop.
+ * @param occupied: Occupied squares.
+ * @return The bitboard.
+ */
+inline bitboard bishopAttack(int sq, bitboard occupied)
+{
+    return BISHOP_MAGIC[sq].attacks[slidingIndex(BISHOP_MAGIC[sq], occupied)];
+}
+
+#endif
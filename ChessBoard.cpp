@@ -17,153 +17,387 @@
 #include <iostream>
 #include <cmath>
 #include <cstring>
+#include <new>
 
 using namespace std;
 
 
+// Castling rights kept when a piece moves from or to each square.
+static const int CASTLING_MASK[64] = {
+    13, 15, 15, 15, 12, 15, 15, 14,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+     7, 15, 15, 15,  3, 15, 15, 11,
+};
+
+// FEN of the start position.
+static const string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+// Names of the promotion types, in the order of piece types.
+static const char* PROMOTION_NAME[Piece::TYPE_NUM] = {"", "rook", "knight", "bishop", "queen", ""};
+// FEN symbols of each piece code, White ones first, in the order of piece types.
+static const char* FEN_SYMBOL = "PRNBQKprnbqk";
+
+const int ChessBoard::PIECE_VALUE[Piece::TYPE_NUM] = {100, 500, 320, 330, 900, 0};
+
+// Piece-square tables of each piece type for White, from A1 to H8. Black uses the vertically mirrored grid.
+static const int PIECE_SQUARE[Piece::TYPE_NUM][ChessBoard::ROW * ChessBoard::COL] = {
+    // Pawn.
+    {
+          0,   0,   0,   0,   0,   0,   0,   0,
+          5,  10,  10, -20, -20,  10,  10,   5,
+          5,  -5, -10,   0,   0, -10,  -5,   5,
+          0,   0,   0,  20,  20,   0,   0,   0,
+          5,   5,  10,  25,  25,  10,   5,   5,
+         10,  10,  20,  30,  30,  20,  10,  10,
+         50,  50,  50,  50,  50,  50,  50,  50,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    },
+    // Rook.
+    {
+          0,   0,   0,   5,   5,   0,   0,   0,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+         -5,   0,   0,   0,   0,   0,   0,  -5,
+          5,  10,  10,  10,  10,  10,  10,   5,
+          0,   0,   0,   0,   0,   0,   0,   0,
+    },
+    // Knight.
+    {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50,
+    },
+    // Bishop.
+    {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20,
+    },
+    // Queen.
+    {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+    },
+    // King.
+    {
+         20,  30,  10,   0,   0,  10,  30,  20,
+         20,  20,   0,   0,   0,   0,  20,  20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+    },
+};
+
+// Piece values of the static exchange evaluation, where a king is worth more than anything else.
+static const int SEE_VALUE[Piece::TYPE_NUM] = {100, 500, 320, 330, 900, 20000};
+// Piece types from the least valuable to the most valuable.
+static const int SEE_ORDER[Piece::TYPE_NUM] = {Piece::PAWN, Piece::KNIGHT, Piece::BISHOP, Piece::ROOK, Piece::QUEEN,
+    Piece::KING};
+// Mobility bonus of each piece type for each square it can move to, outside the attacks of enemy pawns.
+static const int MOBILITY_BONUS[Piece::TYPE_NUM] = {0, 2, 4, 5, 1, 0};
+// Penalty of each piece type for each square around the enemy king it attacks.
+static const int KING_ATTACK_PENALTY[Piece::TYPE_NUM] = {0, 4, 3, 3, 6, 0};
+// Bonus of each pawn next to its own king.
+static const int PAWN_SHIELD_BONUS = 10;
+
+uint64_t ChessBoard::PIECE_KEY[16][ROW * COL];
+uint64_t ChessBoard::CASTLING_KEY[ALL_CASTLING + 1];
+uint64_t ChessBoard::PASSANT_KEY[COL];
+uint64_t ChessBoard::SIDE_KEY;
+int ChessBoard::PIECE_SCORE[16][ROW * COL];
+
+/*
+ * The Zobrist keys are generated once at startup by a xorshift generator with a fixed seed,
+ * so that the keys of a position are the same across runs and can be stored.
+ * The piece scores are looked up by piece code along with them.
+ */
+static struct ZobristInit
+{
+    ZobristInit()
+    {
+        uint64_t seed = 0x9e3779b97f4a7c15ULL;
+        for (int code = 0; code < 16; code++)
+            for (int sq = 0; sq < ChessBoard::ROW * ChessBoard::COL; sq++)
+                ChessBoard::PIECE_KEY[code][sq] = next(seed);
+        for (int castling = 0; castling <= ChessBoard::ALL_CASTLING; castling++)
+            ChessBoard::CASTLING_KEY[castling] = castling ? next(seed) : 0;
+        for (int c = 0; c < ChessBoard::COL; c++)
+            ChessBoard::PASSANT_KEY[c] = next(seed);
+        ChessBoard::SIDE_KEY = next(seed);
+
+        // Black reads the piece-square tables upside down.
+        for (int side = 0; side < ChessBoard::SIDE; side++)
+            for (int type = 0; type < Piece::TYPE_NUM; type++)
+                for (int sq = 0; sq < ChessBoard::ROW * ChessBoard::COL; sq++)
+                    ChessBoard::PIECE_SCORE[ChessBoard::pieceCode(side, type)][sq] =
+                        ChessBoard::PIECE_VALUE[type] + PIECE_SQUARE[type][side ? sq ^ 56 : sq];
+    }
+    static uint64_t next(uint64_t& seed)
+    {
+        seed ^= seed >> 12;
+        seed ^= seed << 25;
+        seed ^= seed >> 27;
+        return seed * 0x2545f4914f6cdd1dULL;
+    }
+} ZOBRIST_INIT;
+
 ChessBoard::ChessBoard(ostream& ostr):
-    m_ostr(ostr)
+    m_ostr(ostr), m_verbose(true), m_legal_valid(false)
 {
-    // Set all piece pointer to nullptr first.
+    // Set all piece pointer to nullptr and clear the board core first.
     memset(m_board, 0, sizeof(m_board));
+    clearObjects();
+    memset(m_pieces, 0, sizeof(m_pieces));
+    memset(m_occupied, 0, sizeof(m_occupied));
+    m_undo.reserve(MAX_PLY);
     resetBoard();
 }
 
-ChessBoard::~ChessBoard()
+ChessBoard::ChessBoard(const Position& position, ostream& ostr):
+    m_ostr(ostr), m_verbose(true), m_legal_valid(false)
 {
-    // Delete all piece objects.
-    for (int r = 0; r < ROW; r ++)
-        for (int c = 0; c < COL; c ++)
-            delete m_board[r][c];
+    // Set all piece pointer to nullptr and clear the board core first.
+    memset(m_board, 0, sizeof(m_board));
+    clearObjects();
+    m_undo.reserve(MAX_PLY);
+    setPosition(position);
 }
 
-void ChessBoard::resetBoard()
+ChessBoard::ChessBoard(const ChessBoard& other):
+    m_winner(other.m_winner), m_side(other.m_side), m_status(other.m_status),
+    m_castling(other.m_castling), m_passant(other.m_passant), m_halfmove(other.m_halfmove),
+    m_fullmove(other.m_fullmove), m_hash(other.m_hash),
+    m_undo(other.m_undo),
+    m_promotion_move(other.m_promotion_move), m_ostr(other.m_ostr),
+    m_verbose(other.m_verbose), m_legal(other.m_legal), m_legal_valid(other.m_legal_valid)
 {
-    // Delete all piece objects.
-    for (int r = 0; r < ROW; r ++)
-        for (int c = 0; c < COL; c ++)
-            delete m_board[r][c];
-    // Reset all variables.
+    // Copy the board core.
+    memcpy(m_pieces, other.m_pieces, sizeof(m_pieces));
+    memcpy(m_occupied, other.m_occupied, sizeof(m_occupied));
+    memcpy(m_squares, other.m_squares, sizeof(m_squares));
+    memcpy(m_material, other.m_material, sizeof(m_material));
+    memcpy(m_targets, other.m_targets, sizeof(m_targets));
+    m_undo.reserve(MAX_PLY);
+
+    // Set all pointers to nullptr and free all slots first.
     memset(m_board, 0, sizeof(m_board));
+    clearObjects();
     memset(m_king, 0, sizeof(m_king));
     memset(m_passant_pawn, 0, sizeof(m_passant_pawn));
     memset(m_promotion_pawn, 0, sizeof(m_promotion_pawn));
-    m_status = NORMAL;
-    m_side = WHITE;
-    m_winner = UNKNOWN;
 
-    // Generate king first.
-    m_king[WHITE] = new King(this, WHITE, strCoord("E1"));
-    m_king[BLACK] = new King(this, BLACK, strCoord("E8"));
-
-    // Generate all other pieces.
-    setPiece(strCoord("A1"), new Rook(this, WHITE, strCoord("A1")));
-    setPiece(strCoord("B1"), new Knight(this, WHITE, strCoord("B1")));
-    setPiece(strCoord("C1"), new Bishop(this, WHITE, strCoord("C1")));
-    setPiece(strCoord("D1"), new Queen(this, WHITE, strCoord("D1")));
-    setPiece(strCoord("E1"), m_king[WHITE]);
-    setPiece(strCoord("F1"), new Bishop(this, WHITE, strCoord("F1")));
-    setPiece(strCoord("G1"), new Knight(this, WHITE, strCoord("G1")));
-    setPiece(strCoord("H1"), new Rook(this, WHITE, strCoord("H1")));
-
-    setPiece(strCoord("A2"), new Pawn(this, WHITE, strCoord("A2")));
-    setPiece(strCoord("B2"), new Pawn(this, WHITE, strCoord("B2")));
-    setPiece(strCoord("C2"), new Pawn(this, WHITE, strCoord("C2")));
-    setPiece(strCoord("D2"), new Pawn(this, WHITE, strCoord("D2")));
-    setPiece(strCoord("E2"), new Pawn(this, WHITE, strCoord("E2")));
-    setPiece(strCoord("F2"), new Pawn(this, WHITE, strCoord("F2")));
-    setPiece(strCoord("G2"), new Pawn(this, WHITE, strCoord("G2")));
-    setPiece(strCoord("H2"), new Pawn(this, WHITE, strCoord("H2")));
-
-    setPiece(strCoord("A8"), new Rook(this, BLACK, strCoord("A8")));
-    setPiece(strCoord("B8"), new Knight(this, BLACK, strCoord("B8")));
-    setPiece(strCoord("C8"), new Bishop(this, BLACK, strCoord("C8")));
-    setPiece(strCoord("D8"), new Queen(this, BLACK, strCoord("D8")));
-    setPiece(strCoord("E8"), m_king[BLACK]);
-    setPiece(strCoord("F8"), new Bishop(this, BLACK, strCoord("F8")));
-    setPiece(strCoord("G8"), new Knight(this, BLACK, strCoord("G8")));
-    setPiece(strCoord("H8"), new Rook(this, BLACK, strCoord("H8")));
-
-    setPiece(strCoord("A7"), new Pawn(this, BLACK, strCoord("A7")));
-    setPiece(strCoord("B7"), new Pawn(this, BLACK, strCoord("B7")));
-    setPiece(strCoord("C7"), new Pawn(this, BLACK, strCoord("C7")));
-    setPiece(strCoord("D7"), new Pawn(this, BLACK, strCoord("D7")));
-    setPiece(strCoord("E7"), new Pawn(this, BLACK, strCoord("E7")));
-    setPiece(strCoord("F7"), new Pawn(this, BLACK, strCoord("F7")));
-    setPiece(strCoord("G7"), new Pawn(this, BLACK, strCoord("G7")));
-    setPiece(strCoord("H7"), new Pawn(this, BLACK, strCoord("H7")));
-
-    m_ostr << "A new chess game is started!" << endl;
-}
-
-void ChessBoard::submitMove(const std::string src, const std::string dst)
-{
-    // Check if the game is over.
-    if (m_winner != UNKNOWN)
-    {
-        m_ostr << "The game is already over!" << endl;
-        return;
-    }
-
-    // Check if any pawn is waiting to be promoted.
-    else if (m_promotion_pawn[m_side])
+    // Duplicate every piece, and point the special pieces to the duplicates.
+    for (int r = 0; r < ROW; r++)
+        for (int c = 0; c < COL; c++)
+        {
+            Piece* p = other.m_board[r][c];
+            if (!p)
+                continue;
+            Piece* q = createPiece(p->getSide(), p->getType(), p->getPos());
+            q->setMoved(p->getMoved());
+            setPiece(q->getPos(), q);
+            int side = p->getSide();
+            if (p == other.m_king[side])
+                m_king[side] = q;
+            if (p == other.m_passant_pawn[side])
+                m_passant_pawn[side] = q;
+            if (p == other.m_promotion_pawn[side])
+                m_promotion_pawn[side] = q;
+        }
+}
+
+ChessBoard::~ChessBoard()
+{
+    clearObjects();
+}
+
+void ChessBoard::resetBoard()
+{
+    setFEN(START_FEN);
+}
+
+bool ChessBoard::setFEN(const std::string& fen)
+{
+    // Load the board core, and rebuild the piece objects from it.
+    if (!parseFEN(fen))
     {
-        m_ostr << getPlayer(m_side) << " has a pawn to be promoted!" << endl;
-        return;
+        if (m_verbose)
+            m_ostr << fen << " is not a valid FEN!\n";
+        return false;
     }
+    buildObjects();
 
-    // Check if the coordinates are valid.
-    coord s = strCoord(src), d = strCoord(dst);
-    if (!checkCoord(s))
+    // Reset all variables, and check the status of the player to move.
+    m_winner = UNKNOWN;
+    if (m_verbose)
+        m_ostr << "A new chess game is started!\n";
+    updateStatus();
+    return true;
+}
+
+std::string ChessBoard::getFEN()
+{
+    string fen;
+    fen.reserve(96);
+
+    // Piece placement, from the 8th row down to the 1st.
+    for (int r = ROW - 1; r >= 0; r--)
     {
-        m_ostr << src << " is not a valid position!" << endl;
-        return;
+        int empty = 0;
+        for (int c = 0; c < COL; c++)
+        {
+            int code = m_squares[coordSquare(make_pair(r, c))];
+            if (code == NO_PIECE)
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+                fen += (char) ('0' + empty);
+            empty = 0;
+            fen += FEN_SYMBOL[codeSide(code) * Piece::TYPE_NUM + codeType(code)];
+        }
+        if (empty)
+            fen += (char) ('0' + empty);
+        if (r)
+            fen += '/';
     }
-    else if (!checkCoord(d))
+
+    // Playing side, castling rights and en-passant square.
+    fen += m_side ? " b " : " w ";
+    if (!m_castling)
+        fen += '-';
+    for (int i = 0; i < 4; i++)
+        if (m_castling & (1 << i))
+            fen += "KQkq"[i];
+    fen += ' ';
+    if (m_passant == NO_SQUARE)
+        fen += '-';
+    else
     {
-        m_ostr << dst << " is not a valid position!" << endl;
-        return;
+        fen += (char) ('a' + (m_passant & 7));
+        fen += (char) ('1' + (m_passant >> 3));
     }
 
-    // Check if the piece with the coordinate is valid.
-    Piece* piece = getPiece(s);
-    if (!piece)
+    // Move counters.
+    fen += ' ' + to_string(m_halfmove) + ' ' + to_string(m_fullmove);
+    return fen;
+}
+
+/*
+ * Positions off the board are reported as they are written, unless the movement is refused anyway.
+ */
+MoveResult ChessBoard::submitMove(const std::string& src, const std::string& dst)
+{
+    coord s = strCoord(src), d = strCoord(dst);
+    if ((!checkCoord(s) || !checkCoord(d)) && m_winner == UNKNOWN && m_status != DRAW && !m_promotion_pawn[m_side])
     {
-        m_ostr << "There is no piece at position " << src << "!" << endl;
-        return;
+        MoveResult result = {MoveResult::OK, Move(), NO_PIECE, NO_PIECE, false, false, false, m_status};
+        result.code = checkCoord(s) ? MoveResult::INVALID_DESTINATION : MoveResult::INVALID_SOURCE;
+        if (m_verbose)
+            m_ostr << (checkCoord(s) ? dst : src) << " is not a valid position!\n";
+        return result;
     }
-    if (piece->getSide() != m_side)
+    return submitMove(checkCoord(s) ? coordSquare(s) : NO_SQUARE, checkCoord(d) ? coordSquare(d) : NO_SQUARE);
+}
+
+/*
+ * The movement is checked against the legal moves worked out for the current player,
+ * and carried out on the piece objects first, and then on the board core, unless the pawn is waiting to be promoted.
+ * The text, if any, is written once everything is known.
+ */
+MoveResult ChessBoard::submitMove(int src, int dst)
+{
+    MoveResult result = {MoveResult::OK, Move(), NO_PIECE, NO_PIECE, false, false, false, m_status};
+    bool valid = 0 <= src && src < ROW * COL && 0 <= dst && dst < ROW * COL;
+    coord s = squareCoord(src), d = squareCoord(dst);
+    Piece* piece = valid ? getPiece(s) : nullptr;
+    if (piece)
+        result.piece = m_squares[src];
+
+    // Check if the game is over, if any pawn is waiting to be promoted,
+    // if the squares are valid, and if the piece on the square is valid.
+    if (m_winner != UNKNOWN || m_status == DRAW)
+        result.code = MoveResult::GAME_OVER;
+    else if (m_promotion_pawn[m_side])
+        result.code = MoveResult::PROMOTION_PENDING;
+    else if (src < 0 || src >= ROW * COL)
+        result.code = MoveResult::INVALID_SOURCE;
+    else if (!valid)
+        result.code = MoveResult::INVALID_DESTINATION;
+    else if (!piece)
+        result.code = MoveResult::NO_PIECE;
+    else if (piece->getSide() != m_side)
+        result.code = MoveResult::WRONG_SIDE;
+
+    // Look up the legal moves of the current player.
+    else if (!(getLegalTargets(src) & squareBit(dst)))
+        result.code = MoveResult::ILLEGAL_MOVE;
+
+    // Carry out a castling.
+    else if (piece->getType() == Piece::KING && abs(dst - src) == 2)
     {
-        m_ostr << "It is not " << getPlayer(piece->getSide()) << "'s turn to move!" << endl;
-        return;
+        castlingMove(piece, d);
+        result.move = Move(src, dst, dst > src ? Move::KING_CASTLE : Move::QUEEN_CASTLE);
+        result.castling = true;
     }
-
-    // Do the castling check first.
-    if (!castlingCheck(piece, d))
+    else
     {
-        // Dry run the movement, and check if the movement is valid.
-        Piece *obj = dryrunMove(d, piece);
-        if (!obj)
+        // Work out the move for the board core, and the piece which is going to be taken, if any.
+        int flag = m_squares[dst] != NO_PIECE ? Move::CAPTURE : Move::QUIET;
+        Piece* obj = getPiece(d);
+        if (piece->isPawn() && dst == m_passant)
         {
-            m_ostr << piece->getName() << " cannot move to " << dst << "!" << endl;
-            return;
+            flag = Move::EN_PASSANT;
+            obj = getPiece(make_pair(s.first, d.second));
         }
+        else if (piece->isPawn() && abs(s.first - d.first) == 2)
+            flag = Move::DOUBLE_PUSH;
+        result.move = Move(src, dst, flag);
 
-        // Carry on the movement.
-        m_ostr << piece->getName() << " moves from " << src << " to " + dst;
         // If any piece is going to be taken.
-        if (obj != piece)
+        if (obj)
         {
-            m_ostr << " taking " << obj->getName();
+            result.captured = m_squares[coordSquare(obj->getPos())];
             setPiece(obj->getPos(), nullptr);
-            delete obj;
+            destroyPiece(obj);
         }
         // Move the piece.
         setPiece(d, piece);
         piece->setPos(d);
         piece->setMoved(true);
         setPiece(s, nullptr);
-        m_ostr << endl;
+    }
+    if (result.code != MoveResult::OK)
+    {
+        if (m_verbose)
+            printMove(result, src, dst);
+        return result;
     }
 
     // If it is a pawn and it moved two step forward, it can be taken by an en-passant on the next step.
@@ -173,61 +407,181 @@ void ChessBoard::submitMove(const std::string src, const std::string dst)
         m_passant_pawn[m_side] = nullptr;
 
     // Check if a pawn has reached the bottom.
-    if (piece->isPawn() && (piece->getPos().first == (1 - m_side) * (ROW - 1)))
+    // The board core carries out the move once the promotion type is submitted.
+    result.promoting = piece->isPawn() && (piece->getPos().first == (1 - m_side) * (ROW - 1));
+    if (m_verbose)
+        printMove(result, src, dst);
+    if (result.promoting)
     {
         m_promotion_pawn[m_side] = piece;
-        m_ostr << piece->getName() << " is going to be promoted" << endl;
-        return;
+        m_promotion_move = result.move;
+        return result;
     }
 
-    // Swap the current player and check its status.
-    swapPlayer();
+    // Carry out the move on the board core, which swaps the current player, and check its status.
+    makeMove(result.move);
+    updateStatus();
+    result.status = m_status;
+    return result;
 }
 
-void ChessBoard::submitPromotion(std::string type)
+/*
+ * Only the squares and the promotion type of the move are used, the rest is worked out again by the board.
+ */
+MoveResult ChessBoard::submitMove(Move move)
+{
+    MoveResult result = submitMove(move.getSrc(), move.getDst());
+    if (result.code != MoveResult::OK || !result.promoting || !move.isPromotion())
+        return result;
+
+    // Report the piece taken by the movement along with the promotion.
+    int captured = result.captured;
+    result = submitPromotion(move.getPromotion());
+    result.captured = captured;
+    return result;
+}
+
+/*
+ * A type which is not known is reported as it is written, unless the promotion is refused anyway.
+ */
+MoveResult ChessBoard::submitPromotion(const std::string& type)
 {
-    // Check if the game is over.
-    if (m_winner != UNKNOWN)
+    int new_type = -1;
+    for (int t = Piece::ROOK; t <= Piece::QUEEN; t++)
+        if (type == PROMOTION_NAME[t])
+            new_type = t;
+    if (new_type < 0 && m_winner == UNKNOWN && m_status != DRAW && m_promotion_pawn[m_side])
     {
-        m_ostr << "The game is already over!" << endl;
-        return;
+        MoveResult result = {MoveResult::INVALID_TYPE, Move(), NO_PIECE, NO_PIECE, false, false, false, m_status};
+        if (m_verbose)
+            m_ostr << type << " is not a valid type!\n";
+        return result;
     }
+    return submitPromotion(new_type);
+}
+
+MoveResult ChessBoard::submitPromotion(int type)
+{
+    MoveResult result = {MoveResult::OK, Move(), NO_PIECE, NO_PIECE, false, false, false, m_status};
 
-    // Check if there is indeed a pawn waiting to be promoted.
-    if (!m_promotion_pawn[m_side])
+    // Check if the game is over, if there is indeed a pawn waiting to be promoted, and the promotion type.
+    if (m_winner != UNKNOWN || m_status == DRAW)
+        result.code = MoveResult::GAME_OVER;
+    else if (!m_promotion_pawn[m_side])
+        result.code = MoveResult::NO_PROMOTION;
+    else if (type < Piece::ROOK || type > Piece::QUEEN)
+        result.code = MoveResult::INVALID_TYPE;
+    if (result.code != MoveResult::OK)
     {
-        m_ostr << getPlayer(m_side) << " has no pawn to be promoted!" << endl;
-        return;
+        if (m_verbose)
+            printPromotion(result, type);
+        return result;
     }
 
-    // Check the promotion type and generate the new piece.
-    Piece* new_piece = nullptr;
-    if (type == "rook")
-        new_piece = new Rook(this, m_side, m_promotion_pawn[m_side]->getPos());
-    else if (type == "knight")
-        new_piece = new Knight(this, m_side, m_promotion_pawn[m_side]->getPos());
-    else if (type == "bishop")
-        new_piece = new Bishop(this, m_side, m_promotion_pawn[m_side]->getPos());
-    else if (type == "queen")
-        new_piece = new Queen(this, m_side, m_promotion_pawn[m_side]->getPos());
-    if (!new_piece)
+    // Delete the original pawn, and generate the new piece in the slot it frees.
+    coord pos = m_promotion_pawn[m_side]->getPos();
+    destroyPiece(m_promotion_pawn[m_side]);
+    m_promotion_pawn[m_side] = nullptr;
+    setPiece(pos, createPiece(m_side, type, pos));
+
+    result.move = Move(m_promotion_move.getSrc(), m_promotion_move.getDst(),
+                       m_promotion_move.getFlag() | Move::promotionFlag(type));
+    result.piece = pieceCode(m_side, Piece::PAWN);
+    result.promoted = true;
+    if (m_verbose)
+        printPromotion(result, type);
+
+    // Carry out the move on the board core, which swaps the current player, and check its status.
+    makeMove(result.move);
+    m_promotion_move = Move();
+    updateStatus();
+    result.status = m_status;
+    return result;
+}
+
+void ChessBoard::printMove(const MoveResult& result, int src, int dst)
+{
+    switch (result.code)
     {
-        m_ostr << type << " is not a valid type!" << endl;
-        return;
+        case MoveResult::GAME_OVER:
+            m_ostr << "The game is already over!\n";
+            return;
+        case MoveResult::PROMOTION_PENDING:
+            m_ostr << getPlayer(m_side) << " has a pawn to be promoted!\n";
+            return;
+        case MoveResult::INVALID_SOURCE:
+            m_ostr << src << " is not a valid square!\n";
+            return;
+        case MoveResult::INVALID_DESTINATION:
+            m_ostr << dst << " is not a valid square!\n";
+            return;
+        case MoveResult::NO_PIECE:
+            m_ostr << "There is no piece at position ";
+            printSquare(src);
+            m_ostr << "!\n";
+            return;
+        case MoveResult::WRONG_SIDE:
+            m_ostr << "It is not " << getPlayer(codeSide(result.piece)) << "'s turn to move!\n";
+            return;
+        case MoveResult::ILLEGAL_MOVE:
+            printPiece(result.piece);
+            m_ostr << " cannot move to ";
+            printSquare(dst);
+            m_ostr << "!\n";
+            return;
     }
 
-    m_ostr << m_promotion_pawn[m_side]->getName() << " at " << coordStr(m_promotion_pawn[m_side]->getPos());
+    printPiece(result.piece);
+    m_ostr << (result.castling ? " castling from " : " moves from ");
+    printSquare(src);
+    m_ostr << " to ";
+    printSquare(dst);
 
-    // Delete the original pawn, set the new pawn.
-    setPiece(m_promotion_pawn[m_side]->getPos(), nullptr);
-    delete m_promotion_pawn[m_side];
-    m_promotion_pawn[m_side] = nullptr;
-    setPiece(new_piece->getPos(), new_piece);
+    // The rook of a castling moves from the corner to the square the king passes.
+    if (result.castling)
+    {
+        int d = dst > src ? 1 : -1;
+        m_ostr << " with ";
+        printPiece(pieceCode(codeSide(result.piece), Piece::ROOK));
+        m_ostr << " from ";
+        printSquare(d > 0 ? src + 3 : src - 4);
+        m_ostr << " to ";
+        printSquare(src + d);
+    }
+    else if (result.captured != NO_PIECE)
+    {
+        m_ostr << " taking ";
+        printPiece(result.captured);
+    }
+    m_ostr << '\n';
+    if (result.promoting)
+    {
+        printPiece(result.piece);
+        m_ostr << " is going to be promoted\n";
+    }
+}
 
-    m_ostr << " get promoted and become " << new_piece->getName() << endl;
+void ChessBoard::printPromotion(const MoveResult& result, int type)
+{
+    switch (result.code)
+    {
+        case MoveResult::GAME_OVER:
+            m_ostr << "The game is already over!\n";
+            return;
+        case MoveResult::NO_PROMOTION:
+            m_ostr << getPlayer(m_side) << " has no pawn to be promoted!\n";
+            return;
+        case MoveResult::INVALID_TYPE:
+            m_ostr << type << " is not a valid type!\n";
+            return;
+    }
 
-    // Swap the player.
-    swapPlayer();
+    printPiece(result.piece);
+    m_ostr << " at ";
+    printSquare(result.move.getDst());
+    m_ostr << " get promoted and become ";
+    printPiece(pieceCode(codeSide(result.piece), type));
+    m_ostr << '\n';
 }
 
 void ChessBoard::drawBoard(bool simple)
@@ -236,172 +590,549 @@ void ChessBoard::drawBoard(bool simple)
     if (!simple)
     {
         // Output relavent information.
-        m_ostr << "Current Player: " << getPlayer(m_side) << endl;
+        m_ostr << "Current Player: " << getPlayer(m_side) << '\n';
         m_ostr << "Status: ";
         switch (m_status)
         {
             case CHECK:
             {
-                m_ostr << "Checked" << endl;
+                m_ostr << "Checked\n";
                 break;
             }
             case STALEMATE:
             {
-                m_ostr << "Stalemated" << endl;
+                m_ostr << "Stalemated\n";
                 break;
             }
             case CHECKMATE:
             {
-                m_ostr << "Checkmated" << endl;
+                m_ostr << "Checkmated\n";
+                break;
+            }
+            case DRAW:
+            {
+                m_ostr << "Drawn\n";
                 break;
             }
             default:
-                m_ostr << "Normal" << endl;
+                m_ostr << "Normal\n";
         }
         m_ostr << "Promoting: ";
         if (m_promotion_pawn[m_side])
-            m_ostr << "Yes, " << coordStr(m_promotion_pawn[m_side]->getPos()) << endl;
+        {
+            m_ostr << "Yes, ";
+            printSquare(coordSquare(m_promotion_pawn[m_side]->getPos()));
+            m_ostr << '\n';
+        }
         else
-            m_ostr << "None" << endl;
-        m_ostr << endl;
+            m_ostr << "None\n";
+        m_ostr << '\n';
 
         // Output the whole chess board.
-        m_ostr << "  A B C D E F G H  " << endl;
-        m_ostr << " +-+-+-+-+-+-+-+-+ " << endl;
+        m_ostr << "  A B C D E F G H  \n";
+        m_ostr << " +-+-+-+-+-+-+-+-+ \n";
         for (int r = ROW - 1; r >= 0; r--)
         {
             m_ostr << (char) ('1' + r);
             for (int c = 0; c < COL; c++)
                 m_ostr << '|' << (!getPiece(make_pair(r, c)) ? ' ' : getPiece(make_pair(r, c))->getSymbol());
-            m_ostr << '|' << (char) ('1' + r) << endl;
-            m_ostr << " +-+-+-+-+-+-+-+-+ " << endl;
+            m_ostr << '|' << (char) ('1' + r) << '\n';
+            m_ostr << " +-+-+-+-+-+-+-+-+ \n";
         }
-        m_ostr << "  A B C D E F G H  " << endl;
+        m_ostr << "  A B C D E F G H  \n";
     }
 
     // In a simple mode.
     else
     {
         // Output information in a simple form.
-        m_ostr << m_side << " " << m_status << " " << (m_promotion_pawn[m_side] ? 1 : 0) << endl;
+        m_ostr << m_side << " " << m_status << " " << (m_promotion_pawn[m_side] ? 1 : 0) << '\n';
 
         // And the board.
         for (int r = ROW - 1; r >= 0; r--)
         {
             for (int c = 0; c < COL; c++)
                 m_ostr << (!getPiece(make_pair(r, c)) ? '.' : getPiece(make_pair(r, c))->getSymbol());
-            m_ostr << endl;
+            m_ostr << '\n';
         }
     }
 }
 
-/*
- * To implement this function, four steps are needed.
- * 1. Check if the movement is valid for the piece itself.
- * 2. If true, carry out the movement.
- * 3. Check if the king is under direct attack after the movement, and record the result.
- * 4. Rollback the movement.
- */
-Piece* ChessBoard::dryrunMove(coord dst, Piece* piece)
-{
-    // Check if the movement is valid for the piece.
-    Piece* obj = piece->pieceCheck(dst);
-    if (!obj)
-        return nullptr;
-    else if (obj == piece)
-        obj = nullptr;
-
-    // Record the original information for the pieces.
-    bool piece_moved = piece->getMoved();
-    coord piece_src = piece->getPos(), obj_src = obj ? obj->getPos() : make_pair(-1, -1);
-
-    // Carry out the movement.
-    if (obj)
-        setPiece(obj_src, nullptr);
-    setPiece(dst, piece);
-    piece->setPos(dst);
-    piece->setMoved(true);
-    setPiece(piece_src, nullptr);
-
-    // Check if the king is then under attack.
-    bool res = !checkCheck(m_side);
-
-    // Rollback the movement.
-    setPiece(piece_src, piece);
-    piece->setMoved(piece_moved);
-    piece->setPos(piece_src);
-    setPiece(dst, nullptr);
-    if (obj)
-        setPiece(obj_src, obj);
-
-    // Return the result.
-    if (!res)
-        return nullptr;
-    return obj ? obj : piece;
-}
-
-void ChessBoard::swapPlayer()
-{
-    // Swap the player and reset the status.
-    m_side = 1 - m_side;
+void ChessBoard::updateStatus()
+{
+    // Reset the status.
     m_status = NORMAL;
 
-    // Check wheather the player is in checkmate, check or stalemate.
-    bool check = checkCheck(m_side), mate = mateCheck(m_side);
+    // Check wheather the player is in checkmate or stalemate, the game is drawn, or the player is in check.
+    bool check = checkCheck(m_side), mate = mateCheck();
     if (check && mate)
     {
         m_status = CHECKMATE;
         m_winner = 1 - m_side;
-        m_ostr << getPlayer(m_side) << " is in checkmate" << endl;
+        if (m_verbose)
+            m_ostr << getPlayer(m_side) << " is in checkmate\n";
+    }
+    else if (mate)
+    {
+        m_status = STALEMATE;
+        m_winner = 1 - m_side;
+        if (m_verbose)
+            m_ostr << getPlayer(m_side) << " is in stalemate\n";
+    }
+    else if (isRepetition())
+    {
+        m_status = DRAW;
+        if (m_verbose)
+            m_ostr << "The game is drawn by threefold repetition\n";
+    }
+    else if (m_halfmove >= FIFTY_MOVE)
+    {
+        m_status = DRAW;
+        if (m_verbose)
+            m_ostr << "The game is drawn by the fifty-move rule\n";
+    }
+    else if (isInsufficientMaterial())
+    {
+        m_status = DRAW;
+        if (m_verbose)
+            m_ostr << "The game is drawn by insufficient material\n";
     }
     else if (check)
     {
         m_status = CHECK;
-        m_ostr << getPlayer(m_side) << " is in check" << endl;
+        if (m_verbose)
+            m_ostr << getPlayer(m_side) << " is in check\n";
     }
-    else if (mate)
+}
+
+/*
+ * Positions before the last pawn move or capture can never appear again,
+ * so only the last (halfmove clock) plies of the history are scanned, and only those with the same side to move.
+ */
+bool ChessBoard::isRepetition(int times)
+{
+    int count = 1, end = max(0, (int) m_undo.size() - m_halfmove);
+    for (int i = (int) m_undo.size() - 2; i >= end; i -= 2)
+        if (m_undo[i].hash == m_hash && ++count >= times)
+            return true;
+    return count >= times;
+}
+
+/*
+ * The material is insufficient when there are only kings and at most one knight or bishop,
+ * or only kings and bishops which all stand on grids of the same colour.
+ */
+bool ChessBoard::isInsufficientMaterial()
+{
+    // Any pawn, rook or queen is sufficient.
+    for (int side = 0; side < SIDE; side++)
+        if (m_pieces[side][Piece::PAWN] | m_pieces[side][Piece::ROOK] | m_pieces[side][Piece::QUEEN])
+            return false;
+
+    // A single minor piece is insufficient.
+    bitboard knights = m_pieces[WHITE][Piece::KNIGHT] | m_pieces[BLACK][Piece::KNIGHT];
+    bitboard bishops = m_pieces[WHITE][Piece::BISHOP] | m_pieces[BLACK][Piece::BISHOP];
+    if (popCount(knights | bishops) <= 1)
+        return true;
+
+    // So are bishops on grids of the same colour.
+    const bitboard DARK = 0xaa55aa55aa55aa55ULL;
+    return !knights && (!(bishops & DARK) || !(bishops & ~DARK));
+}
+
+void ChessBoard::makeMove(Move move)
+{
+    int src = move.getSrc(), dst = move.getDst(), flag = move.getFlag();
+
+    // Record the state before the move.
+    Undo undo;
+    undo.move = move;
+    undo.captured = NO_PIECE;
+    undo.castling = (int8_t) m_castling;
+    undo.passant = (int8_t) m_passant;
+    undo.halfmove = (uint16_t) m_halfmove;
+    undo.hash = m_hash;
+
+    // The halfmove clock is reset by a pawn move or a capture, and stops at the top of its range.
+    if (move.isCapture() || codeType(m_squares[src]) == Piece::PAWN)
+        m_halfmove = 0;
+    else if (m_halfmove < 0xffff)
+        m_halfmove++;
+
+    // Take the piece, if any. The pawn taken by an en-passant is right behind the destination.
+    if (flag == Move::EN_PASSANT)
     {
-        m_status = STALEMATE;
-        m_winner = 1 - m_side;
-        m_ostr << getPlayer(m_side) << " is in stalemate" << endl;
+        int tar = m_side ? dst + COL : dst - COL;
+        undo.captured = m_squares[tar];
+        removePiece(tar);
+    }
+    else if (move.isCapture())
+    {
+        undo.captured = m_squares[dst];
+        removePiece(dst);
+    }
+
+    // Move the piece, and the rook as well for a castling.
+    movePiece(src, dst);
+    if (move.isPromotion())
+    {
+        removePiece(dst);
+        putPiece(dst, pieceCode(m_side, move.getPromotion()));
     }
+    else if (flag == Move::KING_CASTLE)
+        movePiece(dst + 1, dst - 1);
+    else if (flag == Move::QUEEN_CASTLE)
+        movePiece(dst - 2, dst + 1);
+
+    // Update the state, and swap the current player.
+    // The en-passant square is only kept if any pawn can take it, so that it only matters to the key when it is real.
+    m_hash ^= stateKey(m_castling, m_passant);
+    m_castling &= CASTLING_MASK[src] & CASTLING_MASK[dst];
+    m_passant = NO_SQUARE;
+    if (flag == Move::DOUBLE_PUSH && (attackSet((src + dst) / 2, m_side, Piece::PAWN) & m_pieces[1 - m_side][Piece::PAWN]))
+        m_passant = (src + dst) / 2;
+    m_hash ^= stateKey(m_castling, m_passant) ^ SIDE_KEY;
+    if (m_side == BLACK)
+        m_fullmove++;
+    m_side = 1 - m_side;
+    m_undo.push_back(undo);
+    m_legal_valid = false;
+}
+
+void ChessBoard::unmakeMove()
+{
+    const Undo& undo = m_undo.back();
+    int src = undo.move.getSrc(), dst = undo.move.getDst(), flag = undo.move.getFlag();
+
+    // Restore the state.
+    m_side = 1 - m_side;
+    if (m_side == BLACK)
+        m_fullmove--;
+    m_castling = undo.castling;
+    m_passant = undo.passant;
+    m_halfmove = undo.halfmove;
+
+    // Move the piece back, and the rook as well for a castling.
+    if (undo.move.isPromotion())
+    {
+        removePiece(dst);
+        putPiece(dst, pieceCode(m_side, Piece::PAWN));
+    }
+    else if (flag == Move::KING_CASTLE)
+        movePiece(dst - 1, dst + 1);
+    else if (flag == Move::QUEEN_CASTLE)
+        movePiece(dst + 1, dst - 2);
+    movePiece(dst, src);
+
+    // Put back the piece taken, if any.
+    if (flag == Move::EN_PASSANT)
+        putPiece(m_side ? dst + COL : dst - COL, undo.captured);
+    else if (undo.captured != NO_PIECE)
+        putPiece(dst, undo.captured);
+
+    m_hash = undo.hash;
+    m_undo.pop_back();
+    m_legal_valid = false;
 }
 
-bool ChessBoard::castlingCheck(Piece *king, coord king_dst)
+/*
+ * The position is parsed into local variables first, and written into the board core only when it is valid.
+ * The string is walked by index, so that no substring or stream is created.
+ */
+bool ChessBoard::parseFEN(const std::string& fen)
 {
-    // If it is a castling, king must be not moved, and it must move two steps leftward or rightward.
-    if (king != m_king[m_side] ||
-        king_dst.first != king->getPos().first ||
-        abs(king_dst.second - king->getPos().second) != 2 ||
-        king->getMoved())
+    int8_t squares[ROW * COL];
+    int side, castling = 0, passant = NO_SQUARE, halfmove = 0, fullmove = 1;
+    int kings[SIDE] = {0, 0};
+    size_t i = 0, n = fen.length();
+    memset(squares, NO_PIECE, sizeof(squares));
+
+    // Piece placement, from the 8th row down to the 1st.
+    int r = ROW - 1, c = 0;
+    for (; i < n && fen[i] != ' '; i++)
+    {
+        char ch = fen[i];
+        if (ch == '/')
+        {
+            if (c != COL || r == 0)
+                return false;
+            r--, c = 0;
+        }
+        else if ('1' <= ch && ch <= '8')
+            c += ch - '0';
+        else
+        {
+            const char* symbol = ch ? strchr(FEN_SYMBOL, ch) : nullptr;
+            if (!symbol || c >= COL)
+                return false;
+            int code = pieceCode((symbol - FEN_SYMBOL) / Piece::TYPE_NUM, (symbol - FEN_SYMBOL) % Piece::TYPE_NUM);
+            // No pawn can stand on the first or the last row.
+            if (codeType(code) == Piece::PAWN && (r == 0 || r == ROW - 1))
+                return false;
+            if (codeType(code) == Piece::KING)
+                kings[codeSide(code)]++;
+            squares[coordSquare(make_pair(r, c++))] = (int8_t) code;
+        }
+        if (c > COL)
+            return false;
+    }
+    if (r != 0 || c != COL || kings[WHITE] != 1 || kings[BLACK] != 1)
         return false;
 
-    // Check if the path is clear, toward the corner at that row.
-    int d = king_dst.second > king->getPos().second ? 1 : -1;
-    int r = king->getPos().first, c = king->getPos().second + d;
-    while (0 < c && c < COL - 1)
+    // Playing side.
+    if (i + 2 > n || (fen[i + 1] != 'w' && fen[i + 1] != 'b'))
+        return false;
+    side = fen[i + 1] == 'w' ? WHITE : BLACK;
+    i += 2;
+
+    // Castling rights.
+    if (i >= n || fen[i] != ' ' || ++i >= n)
+        return false;
+    if (fen[i] == '-')
+        i++;
+    else
+        for (; i < n && fen[i] != ' '; i++)
+        {
+            const char* right = strchr("KQkq", fen[i]);
+            if (!fen[i] || !right)
+                return false;
+            castling |= 1 << (right - "KQkq");
+        }
+
+    // En-passant square, which must be right behind a pawn just moved two steps forward.
+    if (i >= n || fen[i] != ' ' || ++i >= n)
+        return false;
+    if (fen[i] == '-')
+        i++;
+    else
+    {
+        if (i + 2 > n || fen[i] < 'a' || fen[i] > 'h' || fen[i + 1] != (side ? '3' : '6'))
+            return false;
+        passant = coordSquare(make_pair(fen[i + 1] - '1', fen[i] - 'a'));
+        int pawn = side ? passant + COL : passant - COL;
+        if (squares[pawn] != pieceCode(1 - side, Piece::PAWN) || squares[passant] != NO_PIECE)
+            return false;
+        i += 2;
+    }
+
+    // Optional halfmove clock and fullmove number, each at most 0xffff as kept by Position, so five digits at most.
+    int* counters[2] = {&halfmove, &fullmove};
+    for (int k = 0; k < 2 && i < n; k++)
     {
-        if (getPiece(make_pair(r, c)))
+        if (fen[i] != ' ' || ++i >= n || fen[i] < '0' || fen[i] > '9')
             return false;
-        c += d;
+        size_t begin = i;
+        for (*counters[k] = 0; i < n && '0' <= fen[i] && fen[i] <= '9'; i++)
+        {
+            if (i - begin == 5)
+                return false;
+            *counters[k] = *counters[k] * 10 + (fen[i] - '0');
+        }
+        if (*counters[k] > 0xffff)
+            return false;
+    }
+    if (i != n)
+        return false;
+
+    // The player not to move must not be in check, otherwise the king could be taken.
+    int other_king = 0;
+    while (squares[other_king] != pieceCode(1 - side, Piece::KING))
+        other_king++;
+    bitboard pieces[SIDE][Piece::TYPE_NUM], occupied[SIDE];
+    memcpy(pieces, m_pieces, sizeof(pieces));
+    memcpy(occupied, m_occupied, sizeof(occupied));
+    memset(m_pieces, 0, sizeof(m_pieces));
+    memset(m_occupied, 0, sizeof(m_occupied));
+    for (int sq = 0; sq < ROW * COL; sq++)
+        if (squares[sq] != NO_PIECE)
+        {
+            m_pieces[codeSide(squares[sq])][codeType(squares[sq])] |= squareBit(sq);
+            m_occupied[codeSide(squares[sq])] |= squareBit(sq);
+        }
+    if (isSquareAttacked(other_king, side))
+    {
+        memcpy(m_pieces, pieces, sizeof(pieces));
+        memcpy(m_occupied, occupied, sizeof(occupied));
+        return false;
+    }
+
+    // A castling right is only kept if the king and the rook are on their original grids.
+    static const int CASTLING_ROOK[4] = {7, 0, 63, 56};
+    Position position;
+    memcpy(position.squares, squares, sizeof(squares));
+    position.side = (int8_t) side;
+    position.castling = 0;
+    for (int k = 0; k < 4; k++)
+        if ((castling & (1 << k)) && squares[k < 2 ? 4 : 60] == pieceCode(k >> 1, Piece::KING) &&
+            squares[CASTLING_ROOK[k]] == pieceCode(k >> 1, Piece::ROOK))
+            position.castling |= 1 << k;
+
+    // So is the en-passant square, as in makeMove.
+    position.passant = NO_SQUARE;
+    if (passant != NO_SQUARE && (attackSet(passant, 1 - side, Piece::PAWN) & m_pieces[side][Piece::PAWN]))
+        position.passant = (int8_t) passant;
+
+    position.halfmove = (uint16_t) halfmove;
+    position.fullmove = (uint16_t) max(fullmove, 1);
+    loadPosition(position);
+    return true;
+}
+
+Position ChessBoard::getPosition()
+{
+    Position position;
+    memcpy(position.squares, m_squares, sizeof(m_squares));
+    position.hash = m_hash;
+    position.side = (int8_t) m_side;
+    position.castling = (int8_t) m_castling;
+    position.passant = (int8_t) m_passant;
+    position.halfmove = (uint16_t) m_halfmove;
+    position.fullmove = (uint16_t) m_fullmove;
+    return position;
+}
+
+void ChessBoard::setPosition(const Position& position)
+{
+    // Load the board core, rebuild the piece objects from it, and check the status of the player to move.
+    loadPosition(position);
+    buildObjects();
+    m_winner = UNKNOWN;
+    updateStatus();
+}
+
+void ChessBoard::loadPosition(const Position& position)
+{
+    // Every new position (setPosition, setFEN and resetBoard) comes through here.
+    m_legal_valid = false;
+    m_hash = 0;
+    memset(m_material, 0, sizeof(m_material));
+    memset(m_pieces, 0, sizeof(m_pieces));
+    memset(m_occupied, 0, sizeof(m_occupied));
+    memset(m_squares, NO_PIECE, sizeof(m_squares));
+    for (int sq = 0; sq < ROW * COL; sq++)
+        if (position.squares[sq] != NO_PIECE)
+            putPiece(sq, position.squares[sq]);
+    m_side = position.side;
+    m_castling = position.castling;
+    m_passant = position.passant;
+    m_halfmove = position.halfmove;
+    m_fullmove = position.fullmove;
+    m_hash ^= stateKey(m_castling, m_passant) ^ (m_side ? SIDE_KEY : 0);
+    m_undo.clear();
+    m_promotion_move = Move();
+}
+
+void ChessBoard::buildObjects()
+{
+    // Delete all piece objects.
+    clearObjects();
+    memset(m_king, 0, sizeof(m_king));
+    memset(m_passant_pawn, 0, sizeof(m_passant_pawn));
+    memset(m_promotion_pawn, 0, sizeof(m_promotion_pawn));
+
+    // Generate a piece for each square of the core.
+    for (int sq = 0; sq < ROW * COL; sq++)
+    {
+        int code = m_squares[sq];
+        if (code == NO_PIECE)
+            continue;
+        Piece* piece = createPiece(codeSide(code), codeType(code), squareCoord(sq));
+        setPiece(piece->getPos(), piece);
+        if (codeType(code) == Piece::KING)
+            m_king[codeSide(code)] = piece;
+        // Only a pawn cares if it has been moved, which is the case once it leaves its original row.
+        if (codeType(code) == Piece::PAWN && (sq >> 3) != (codeSide(code) ? ROW - 2 : 1))
+            piece->setMoved(true);
+    }
+
+    // The pawn which can be taken by an en-passant is right in front of the en-passant square.
+    if (m_passant != NO_SQUARE)
+        m_passant_pawn[1 - m_side] = getPiece(squareCoord(m_side ? m_passant + COL : m_passant - COL));
+}
+
+/*
+ * There is never more pieces than squares, so a free slot is always there.
+ */
+Piece* ChessBoard::createPiece(int side, int type, coord pos)
+{
+    void* slot = &m_slots[m_free[--m_free_num]];
+    switch (type)
+    {
+        case Piece::PAWN:
+            return new (slot) Pawn(side, pos);
+        case Piece::ROOK:
+            return new (slot) Rook(side, pos);
+        case Piece::KNIGHT:
+            return new (slot) Knight(side, pos);
+        case Piece::BISHOP:
+            return new (slot) Bishop(side, pos);
+        case Piece::QUEEN:
+            return new (slot) Queen(side, pos);
+        default:
+            return new (slot) King(side, pos);
     }
+}
+
+// Pieces are destroyed through Piece*, which has no virtual destructor.
+// That is only sound while no type has anything to destroy, so any type which does must be rejected here.
+static_assert(std::is_trivially_destructible<Piece>::value && std::is_trivially_destructible<King>::value &&
+    std::is_trivially_destructible<Rook>::value && std::is_trivially_destructible<Bishop>::value &&
+    std::is_trivially_destructible<Queen>::value && std::is_trivially_destructible<Knight>::value &&
+    std::is_trivially_destructible<Pawn>::value, "Piece objects are destroyed through Piece*");
+
+void ChessBoard::destroyPiece(Piece* piece)
+{
+    piece->~Piece();
+    m_free[m_free_num++] = (int8_t) (reinterpret_cast<PieceSlot*>(piece) - m_slots);
+}
+
+void ChessBoard::clearObjects()
+{
+    for (int r = 0; r < ROW; r++)
+        for (int c = 0; c < COL; c++)
+            if (m_board[r][c])
+                m_board[r][c]->~Piece();
+    memset(m_board, 0, sizeof(m_board));
 
-    // Check if the piece at the corner is not moved.
-    // Do not need to check if it is a rook, as if the piece has not been moved, it must be a rook.
-    Piece* rook = getPiece(make_pair(r, c));
-    if (!rook || rook->getMoved())
+    // Slots are taken from the end of the stack, in the order of their indices.
+    for (int i = 0; i < SLOT_NUM; i++)
+        m_free[i] = (int8_t) (SLOT_NUM - 1 - i);
+    m_free_num = SLOT_NUM;
+}
+
+bool ChessBoard::castlingCheck(int king_src, int king_dst)
+{
+    // If it is a castling, the king must be on its original grid, and it must move two steps leftward or rightward.
+    if (king_src != (m_side ? coordSquare(make_pair(ROW - 1, 4)) : coordSquare(make_pair(0, 4))) ||
+        m_squares[king_src] != pieceCode(m_side, Piece::KING) ||
+        abs(king_dst - king_src) != 2)
+        return false;
+
+    // Neither the king nor the rook at the corner must have been moved, which is kept by the castling rights.
+    int d = king_dst > king_src ? 1 : -1;
+    int right = d > 0 ? (m_side ? BLACK_KING_SIDE : WHITE_KING_SIDE) : (m_side ? BLACK_QUEEN_SIDE : WHITE_QUEEN_SIDE);
+    if (!(m_castling & right))
+        return false;
+
+    // Check if the path is clear, toward the corner at that row.
+    int corner = d > 0 ? king_src + 3 : king_src - 4;
+    if (BETWEEN[king_src][corner] & (m_occupied[WHITE] | m_occupied[BLACK]))
         return false;
 
     // Check if the king's path toward its destination is under attack.
-    Piece* p;
-    for (r = 0; r < ROW; r++)
-        for (c = 0; c < COL; c++)
-            if ((p = getPiece(make_pair(r, c))) && p->getSide() == 1 - m_side)
-                for (int i = 0; i < 3; i++)
-                    if (p->pieceCheck(make_pair(king->getPos().first, king->getPos().second + i * d)))
-                        return false;
-
-    // If reaches here, the castling is valid. Generate all positions.
+    for (int sq = king_src; sq != king_dst + d; sq += d)
+        if (isSquareAttacked(sq, 1 - m_side))
+            return false;
+
+    // If reaches here, the castling is valid.
+    return true;
+}
+
+void ChessBoard::castlingMove(Piece *king, coord king_dst)
+{
+    // Generate all positions.
+    int d = king_dst.second > king->getPos().second ? 1 : -1;
+    Piece* rook = getPiece(make_pair(king->getPos().first, d > 0 ? COL - 1 : 0));
     coord king_src = king->getPos(), rook_src = rook->getPos(), rook_dst = king->getPos();
     rook_dst.second = rook_dst.second + d;
 
@@ -416,45 +1147,278 @@ bool ChessBoard::castlingCheck(Piece *king, coord king_dst)
     rook->setPos(rook_dst);
     rook->setMoved(true);
     setPiece(rook_src, nullptr);
+}
 
-    m_ostr << king->getName() << " castling from " << coordStr(king_src) << " to " << coordStr(king_dst) << " with ";
-    m_ostr << rook->getName() << " from " << coordStr(rook_src) << " to " << coordStr(rook_dst) << endl;
+bool ChessBoard::checkCheck(int side)
+{
+    // Check if the grid of the king is under attack.
+    return isSquareAttacked(lsb(m_pieces[side][Piece::KING]), 1 - side);
+}
 
-    return true;
+/*
+ * A piece on the square would attack any piece of the same type which can attack it,
+ * so the attack sets from the square itself are intersected with the attacking pieces.
+ * Pawns are the only exception, whose attack direction depends on the side.
+ */
+bool ChessBoard::isSquareAttacked(int sq, int side)
+{
+    const bitboard* pieces = m_pieces[side];
+    if (attackSet(sq, 1 - side, Piece::PAWN) & pieces[Piece::PAWN])
+        return true;
+    if (attackSet(sq, side, Piece::KNIGHT) & pieces[Piece::KNIGHT])
+        return true;
+    if (attackSet(sq, side, Piece::KING) & pieces[Piece::KING])
+        return true;
+    if (attackSet(sq, side, Piece::ROOK) & (pieces[Piece::ROOK] | pieces[Piece::QUEEN]))
+        return true;
+    return (attackSet(sq, side, Piece::BISHOP) & (pieces[Piece::BISHOP] | pieces[Piece::QUEEN])) != 0;
 }
 
-bool ChessBoard::checkCheck(int side)
+/*
+ * Material and piece-square sums are kept by the core, and the rest is worked out from the bitboards:
+ * mobility counts the squares each piece can move to away from the enemy pawns,
+ * and king safety rewards the pawns around the king and penalizes the enemy pieces attacking the squares around it.
+ */
+int ChessBoard::evaluate()
 {
-    // Get the position of the king.
-    coord tar = m_king[side]->getPos();
+    int score[SIDE] = {m_material[WHITE], m_material[BLACK]};
+    for (int side = 0; side < SIDE; side++)
+    {
+        int enemy = 1 - side, king = lsb(m_pieces[enemy][Piece::KING]);
+        bitboard pawn_attacks = 0, pawns = m_pieces[enemy][Piece::PAWN];
+        while (pawns)
+            pawn_attacks |= PAWN_ATTACK[enemy][popLsb(pawns)];
+        bitboard safe = ~(m_occupied[side] | pawn_attacks), zone = KING_ATTACK[king] | squareBit(king);
 
-    // For all piece in the opposite side, check if it can attack the king.
-    Piece* p;
-    for (int r = 0; r < ROW; r++)
-        for (int c = 0; c < COL; c++)
-            if ((p = getPiece(make_pair(r, c))) && p->getSide() == 1 - side && p->pieceCheck(tar))
-                return true;
-    return false;
+        for (int type = Piece::ROOK; type <= Piece::QUEEN; type++)
+        {
+            bitboard pieces = m_pieces[side][type];
+            while (pieces)
+            {
+                bitboard attack = attackSet(popLsb(pieces), side, type);
+                score[side] += MOBILITY_BONUS[type] * popCount(attack & safe);
+                score[enemy] -= KING_ATTACK_PENALTY[type] * popCount(attack & zone);
+            }
+        }
+        score[enemy] += PAWN_SHIELD_BONUS * popCount(KING_ATTACK[king] & m_pieces[enemy][Piece::PAWN]);
+    }
+    return score[WHITE] - score[BLACK];
 }
 
 /*
- * Castling is not considered as a valid movement here.
- * But this does not influence the result.
- * Because if the castling is available,
- * the two grid next to the king must be safe to move to.
- * Thus, if castling is available, there are definitely other available moves.
- * So castling is not needed to be checked.
+ * The swap list holds the score of each capture if it is the last one, and is then settled backwards,
+ * as each side may stop taking instead. The list is always played out to the end, as cutting it short
+ * would keep the sign of the result but not its value. Sliders behind a piece taking on the square join in as it leaves.
+ * A king only takes if the square is not defended any more. Promotions on the way are not counted.
  */
-bool ChessBoard::mateCheck(int side)
+int ChessBoard::see(Move move)
 {
-    // For all piece with the same side, check if there is a valid move (i.e. a valid destination) for it.
-    Piece* p;
-    for (int r = 0; r < ROW; r++)
-        for (int c = 0; c < COL; c++)
-            if ((p = getPiece(make_pair(r, c))) && p->getSide() == side)
-                for (int i = 0; i < ROW; i++)
-                    for (int j = 0; j < COL; j++)
-                        if (dryrunMove(make_pair(i, j), p))
-                            return false;
-    return true;
+    if (move.isCastling())
+        return 0;
+    int src = move.getSrc(), dst = move.getDst(), side = m_side;
+    bitboard occupied = m_occupied[WHITE] | m_occupied[BLACK], from = squareBit(src);
+    bitboard diagonal = m_pieces[WHITE][Piece::BISHOP] | m_pieces[BLACK][Piece::BISHOP] |
+        m_pieces[WHITE][Piece::QUEEN] | m_pieces[BLACK][Piece::QUEEN];
+    bitboard straight = m_pieces[WHITE][Piece::ROOK] | m_pieces[BLACK][Piece::ROOK] |
+        m_pieces[WHITE][Piece::QUEEN] | m_pieces[BLACK][Piece::QUEEN];
+
+    int gain[32], depth = 0, type = codeType(m_squares[src]);
+    gain[0] = m_squares[dst] != NO_PIECE ? SEE_VALUE[codeType(m_squares[dst])] : 0;
+    if (move.getFlag() == Move::EN_PASSANT)
+    {
+        gain[0] = SEE_VALUE[Piece::PAWN];
+        occupied ^= squareBit(side ? dst + COL : dst - COL);
+    }
+    if (move.isPromotion())
+    {
+        gain[0] += SEE_VALUE[move.getPromotion()] - SEE_VALUE[Piece::PAWN];
+        type = move.getPromotion();
+    }
+
+    bitboard attackers = attackersTo(dst, WHITE, occupied) | attackersTo(dst, BLACK, occupied);
+    do
+    {
+        // The piece just moved to the square is taken next, if the side to take does not stop.
+        depth++;
+        gain[depth] = SEE_VALUE[type] - gain[depth - 1];
+        occupied &= ~from;
+        attackers = (attackers | (rookAttack(dst, occupied) & straight) | (bishopAttack(dst, occupied) & diagonal)) &
+            occupied;
+
+        // The least valuable piece of the other side takes next.
+        side = 1 - side;
+        from = 0;
+        for (int i = 0; i < Piece::TYPE_NUM && !from; i++)
+            if (attackers & m_pieces[side][SEE_ORDER[i]])
+            {
+                type = SEE_ORDER[i];
+                from = attackers & m_pieces[side][type] & -(attackers & m_pieces[side][type]);
+            }
+        if (type == Piece::KING && (attackers & m_occupied[1 - side]))
+            break;
+    } while (from);
+
+    while (--depth)
+        gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
+    return gain[0];
+}
+
+bool ChessBoard::isLegalMove(Move move)
+{
+    if (!(m_occupied[m_side] & squareBit(move.getSrc())))
+        return false;
+    MoveList list;
+    generateLegalMoves(list, ALL_MOVES, squareBit(move.getSrc()));
+    return list.contains(move);
+}
+
+bitboard ChessBoard::attackersTo(int sq, int side, bitboard occupied)
+{
+    const bitboard* pieces = m_pieces[side];
+    return (PAWN_ATTACK[1 - side][sq] & pieces[Piece::PAWN]) | (KNIGHT_ATTACK[sq] & pieces[Piece::KNIGHT]) |
+        (KING_ATTACK[sq] & pieces[Piece::KING]) |
+        (rookAttack(sq, occupied) & (pieces[Piece::ROOK] | pieces[Piece::QUEEN])) |
+        (bishopAttack(sq, occupied) & (pieces[Piece::BISHOP] | pieces[Piece::QUEEN]));
+}
+
+bool ChessBoard::legalCheck(Move move)
+{
+    // Carry out the move, check if the king of the moving side is under attack, and take it back.
+    makeMove(move);
+    bool res = !checkCheck(1 - m_side);
+    unmakeMove();
+    return res;
+}
+
+bool ChessBoard::mateCheck()
+{
+    // The player is mated (or stalemated) if there is no legal move at all.
+    // The moves are kept, for checking the next movement and for the clients.
+    updateLegalMoves();
+    return m_legal.size() == 0;
+}
+
+void ChessBoard::updateLegalMoves()
+{
+    generateLegalMoves(m_legal);
+    memset(m_targets, 0, sizeof(m_targets));
+    for (const Move& move: m_legal)
+        m_targets[move.getSrc()] |= squareBit(move.getDst());
+    m_legal_valid = true;
+}
+
+bitboard ChessBoard::attackSet(int sq, int side, int type)
+{
+    bitboard occupied = m_occupied[WHITE] | m_occupied[BLACK];
+    switch (type)
+    {
+        case Piece::PAWN:
+            return PAWN_ATTACK[side][sq];
+        case Piece::KNIGHT:
+            return KNIGHT_ATTACK[sq];
+        case Piece::KING:
+            return KING_ATTACK[sq];
+        case Piece::ROOK:
+            return rookAttack(sq, occupied);
+        case Piece::BISHOP:
+            return bishopAttack(sq, occupied);
+        default:
+            return rookAttack(sq, occupied) | bishopAttack(sq, occupied);
+    }
+}
+
+/*
+ * Candidate destinations are generated from the bitboards, and filtered by masks worked out once for the position:
+ * while in check, a piece other than the king must take or block a single checker,
+ * and a pinned piece must stay on the line between its king and the pinning piece.
+ * Only the king's destinations are tested against attacks, with the king taken off the board,
+ * so that it does not hide a square behind itself from a slider. An en-passant takes two pieces off a line at once,
+ * so it is still tried on the core.
+ */
+void ChessBoard::generateLegalMoves(MoveList& list, int kinds, bitboard from)
+{
+    list.clear();
+    bitboard own = m_occupied[m_side], enemy = m_occupied[1 - m_side];
+    bitboard occupied = own | enemy;
+    bitboard passant = m_passant != NO_SQUARE ? squareBit(m_passant) : 0;
+    int step = m_side ? -COL : COL, start_row = m_side ? ROW - 2 : 1, last_row = m_side ? 0 : ROW - 1;
+    int king = lsb(m_pieces[m_side][Piece::KING]);
+    const bitboard* theirs = m_pieces[1 - m_side];
+
+    // The squares to move to for pieces other than the king, none if there are two checkers.
+    bitboard checkers = attackersTo(king, 1 - m_side, occupied);
+    bitboard evasion = ~own;
+    if (checkers)
+        evasion &= (checkers & (checkers - 1)) ? 0 : BETWEEN[king][lsb(checkers)] | checkers;
+
+    // Captures and promotions on one side, the other moves on the other side.
+    bitboard takes = (kinds & CAPTURE_MOVES) ? enemy : 0, last = (bitboard) 0xff << (last_row * COL);
+    bitboard targets = takes | ((kinds & QUIET_MOVES) ? ~occupied : 0);
+    bitboard pushes = ((kinds & CAPTURE_MOVES) ? last : 0) | ((kinds & QUIET_MOVES) ? ~last : 0);
+
+    // A piece is pinned if it is the only piece between the king and a slider looking at the king through it.
+    bitboard pinned = 0;
+    bitboard snipers = (rookAttack(king, enemy) & (theirs[Piece::ROOK] | theirs[Piece::QUEEN])) |
+        (bishopAttack(king, enemy) & (theirs[Piece::BISHOP] | theirs[Piece::QUEEN]));
+    while (snipers)
+    {
+        bitboard between = BETWEEN[king][popLsb(snipers)] & occupied;
+        if (between && !(between & (between - 1)) && (between & own))
+            pinned |= between;
+    }
+
+    bitboard pieces = own & from;
+    while (pieces)
+    {
+        int src = popLsb(pieces), type = codeType(m_squares[src]);
+
+        // Generate candidate destinations.
+        bitboard dst;
+        if (type == Piece::PAWN)
+        {
+            dst = attackSet(src, m_side, type) & takes;
+            if (!(occupied & squareBit(src + step)))
+            {
+                dst |= squareBit(src + step) & pushes;
+                if ((src >> 3) == start_row && !(occupied & squareBit(src + 2 * step)))
+                    dst |= squareBit(src + 2 * step) & pushes;
+            }
+            if ((kinds & CAPTURE_MOVES) && (attackSet(src, m_side, type) & passant) &&
+                legalCheck(Move(src, m_passant, Move::EN_PASSANT)))
+                list.push(Move(src, m_passant, Move::EN_PASSANT));
+        }
+        else
+            dst = attackSet(src, m_side, type) & targets;
+
+        // Keep the destinations which do not leave the king under attack.
+        if (type != Piece::KING)
+        {
+            dst &= evasion;
+            if (pinned & squareBit(src))
+                dst &= LINE[king][src];
+        }
+        while (dst)
+        {
+            int tar = popLsb(dst);
+            if (type == Piece::KING && attackersTo(tar, 1 - m_side, occupied ^ squareBit(src)))
+                continue;
+            int flag = (enemy & squareBit(tar)) ? Move::CAPTURE : Move::QUIET;
+            if (type == Piece::PAWN && abs(tar - src) == 2 * COL)
+                flag = Move::DOUBLE_PUSH;
+            if (type == Piece::PAWN && (tar >> 3) == last_row)
+                for (int promote = Move::PROMOTE_KNIGHT; promote <= Move::PROMOTE_QUEEN; promote++)
+                    list.push(Move(src, tar, promote | flag));
+            else
+                list.push(Move(src, tar, flag));
+        }
+
+        // Castling on both sides.
+        if (type == Piece::KING && !checkers && (kinds & QUIET_MOVES))
+        {
+            if (castlingCheck(src, src + 2))
+                list.push(Move(src, src + 2, Move::KING_CASTLE));
+            if (castlingCheck(src, src - 2))
+                list.push(Move(src, src - 2, Move::QUEEN_CASTLE));
+        }
+    }
 }
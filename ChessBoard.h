@@ -15,18 +15,77 @@
 #ifndef _CHESS_BOARD_H_
 #define _CHESS_BOARD_H_
 
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
+#include "Bitboard.h"
+#include "Move.h"
 #include "Piece.h"
 
 
+/**
+ * Result of a movement or a promotion submitted to the board.
+ */
+struct MoveResult
+{
+    // Result codes, anything but OK means the board is left unchanged.
+    static const int OK = 0, GAME_OVER = 1, PROMOTION_PENDING = 2, INVALID_SOURCE = 3, INVALID_DESTINATION = 4,
+        NO_PIECE = 5, WRONG_SIDE = 6, ILLEGAL_MOVE = 7, NO_PROMOTION = 8, INVALID_TYPE = 9;
+
+    // Result code.
+    int code;
+    // The move, without the promotion type while the pawn is waiting to be promoted.
+    Move move;
+    // Piece code of the moving piece, and of the piece taken by the movement, NO_PIECE if none.
+    int piece;
+    int captured;
+    // If the movement is a castling.
+    bool castling;
+    // If the pawn is waiting to be promoted after the movement.
+    bool promoting;
+    // If the pawn has been promoted, to the type of the move.
+    bool promoted;
+    // Status of the player to move afterwards.
+    int status;
+};
+
+/**
+ * A position as a plain value, which can be copied by memcpy, stored and sent as it is.
+ * It takes two cache lines, the piece code on each square in the first, and the state of the game in the second.
+ */
+struct alignas(64) Position
+{
+    // Piece code on each square from A1 to H8, the same as in the board core.
+    int8_t squares[64];
+    // Zobrist key, only for reference, as it is worked out again when the position is loaded.
+    uint64_t hash;
+    // Playing side.
+    int8_t side;
+    // Castling rights still available.
+    int8_t castling;
+    // The square a pawn can move to by an en-passant, NO_SQUARE if none.
+    int8_t passant;
+    // Number of plies since the last pawn move or capture.
+    uint16_t halfmove;
+    // Number of the full move.
+    uint16_t fullmove;
+};
+
+static_assert(std::is_trivially_copyable<Position>::value && sizeof(Position) == 128,
+              "Position must be a plain value of two cache lines");
+
 /**
  * Core class for chess game.
  * This class taking all responsibilities of chess game simulation in logic.
  */
 class ChessBoard
 {
+    // Mark the generator of Zobrist keys as friend.
+    friend struct ZobristInit;
+
 public:
     /**
      * Transfer a string into coordinate.
@@ -44,7 +103,8 @@ public:
      */
     inline static std::string coordStr(const coord pos)
     {
-        return std::string(1, pos.second + 'A') + std::string(1, pos.first + '1');
+        const char str[2] = {(char) (pos.second + 'A'), (char) (pos.first + '1')};
+        return std::string(str, 2);
     }
     /**
      * Check if a coordinate is valid.
@@ -71,6 +131,18 @@ public:
      * @param ostr: An ostream object where the output flows to.
      */
     explicit ChessBoard(std::ostream& ostr=std::cout);
+    /**
+     * Constructor from a position, which sets up the board without going through a FEN string.
+     * @param position: The position.
+     * @param ostr: An ostream object where the output flows to.
+     */
+    explicit ChessBoard(const Position& position, std::ostream& ostr=std::cout);
+    /**
+     * Copy constructor, all pieces are duplicated and the output flows to the same ostream.
+     * The history of moves is copied as well. If it is not needed, copying a Position is much cheaper.
+     * @param other: The board to copy.
+     */
+    ChessBoard(const ChessBoard& other);
     /**
      * Deconstructor.
      */
@@ -79,22 +151,218 @@ public:
      * Reset the whole board.
      */
     void resetBoard();
+    /**
+     * Interface function. Set up the board from a FEN string.
+     * The castling rights are only kept where the king and the rook are in place, and the en-passant square
+     * only if a pawn can take it. The halfmove clock and the fullmove number are optional.
+     * @param fen: The FEN string (e.g. "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1").
+     * @return If the string is valid, otherwise the board is left unchanged.
+     */
+    bool setFEN(const std::string& fen);
+    /**
+     * Get the FEN string of the board core.
+     * While a pawn is waiting to be promoted, it is the position before the pawn moves.
+     * @return The FEN string.
+     */
+    std::string getFEN();
+    /**
+     * Get the position of the board core as a plain value.
+     * While a pawn is waiting to be promoted, it is the position before the pawn moves.
+     * @return The position.
+     */
+    Position getPosition();
+    /**
+     * Interface function. Set up the board from a position, such as one from getPosition.
+     * The position must be valid, as it is not checked like a FEN string. The history of moves is not kept.
+     * @param position: The position.
+     */
+    void setPosition(const Position& position);
     /**
      * Interface function. Submit a movement with two two-char strings representing the source and destination.
      * @param src: The source(e.g. "D2").
      * @param dst: The destination(e.g. "D4").
+     * @return The result, which is also written as text if the board is verbose.
+     */
+    MoveResult submitMove(const std::string& src, const std::string& dst);
+    /**
+     * Interface function. Submit a movement with the source and destination squares.
+     * @param src: The source square index.
+     * @param dst: The destination square index.
+     * @return The result, which is also written as text if the board is verbose.
+     */
+    MoveResult submitMove(int src, int dst);
+    /**
+     * Interface function. Submit a packed movement, and the promotion type if it is a promotion.
+     * @param move: The move, whose flag is only used for the promotion type.
+     * @return The result of the promotion if it is carried out, otherwise of the movement.
      */
-    void submitMove(std::string src, std::string dst);
+    MoveResult submitMove(Move move);
     /**
      * Interface function. Submit a pawn promotion with a string representing the promoted type.
      * @param type: One of "queen", "rook", "knight" and "bishop".
+     * @return The result, which is also written as text if the board is verbose.
      */
-    void submitPromotion(std::string type);
+    MoveResult submitPromotion(const std::string& type);
+    /**
+     * Interface function. Submit a pawn promotion with the promoted type.
+     * @param type: One of Piece::QUEEN, Piece::ROOK, Piece::KNIGHT and Piece::BISHOP.
+     * @return The result, which is also written as text if the board is verbose.
+     */
+    MoveResult submitPromotion(int type);
+    /**
+     * Set if the results of the interface functions are written to the output stream as text, which is on by default.
+     * Boards played by programs can turn it off, so that no text is formatted.
+     * @param verbose: If the results are written.
+     */
+    inline void setVerbose(bool verbose)
+    {
+        m_verbose = verbose;
+    }
+    /**
+     * Get the status of the current player.
+     * @return One of NORMAL, CHECK, STALEMATE, CHECKMATE and DRAW.
+     */
+    inline int getStatus()
+    {
+        return m_status;
+    }
+    /**
+     * Check if the current player has a pawn waiting to be promoted.
+     * The board core only carries out the pawn move once the promotion is submitted, so until then
+     * getLegalMoves, getLegalTargets, getFEN, getPosition and getHash are all of the position before it.
+     * @return The result.
+     */
+    inline bool isPromoting()
+    {
+        return m_promotion_pawn[m_side] != nullptr;
+    }
     /**
      * Interface function. Draw the board, either in simple form or cli form.
      * @param simple: Whether this is simple draw.
      */
     void drawBoard(bool simple=false);
+    /**
+     * Generate all legal moves for the current player in one pass, including castling, en-passant and promotion.
+     * A promotion is listed once for each of the four types.
+     * @param list: The list to fill, its previous content is discarded.
+     * @param kinds: Kinds of moves to generate, CAPTURE_MOVES (captures and promotions), QUIET_MOVES or ALL_MOVES.
+     * @param from: The squares of the pieces to generate moves for.
+     */
+    void generateLegalMoves(MoveList& list, int kinds=ALL_MOVES, bitboard from=~(bitboard) 0);
+    /**
+     * Check if a move is legal for the current player, e.g. a move remembered from another position.
+     * @param move: The move.
+     * @return The result.
+     */
+    bool isLegalMove(Move move);
+    /**
+     * Work out the material the current player wins by a move, if both sides keep taking on the destination square
+     * with their least valuable piece, and stop when taking on would lose.
+     * A move to an empty square scores how much the moving piece loses there, so a negative score means it hangs.
+     * @param move: A legal move of the current player.
+     * @return The material gain in centipawns, by the values of PIECE_VALUE.
+     */
+    int see(Move move);
+    /**
+     * Get the legal moves of the current player, kept since they were last worked out for the position.
+     * A promotion is listed once for each of the four types.
+     * While a pawn is waiting to be promoted, they are the moves of the position before the pawn moves.
+     * @return The list.
+     */
+    inline const MoveList& getLegalMoves()
+    {
+        if (!m_legal_valid)
+            updateLegalMoves();
+        return m_legal;
+    }
+    /**
+     * Get the squares a piece of the current player can legally move to.
+     * While a pawn is waiting to be promoted, they are for the position before the pawn moves.
+     * @param sq: The square of the piece.
+     * @return The bitboard, empty if there is no piece of the current player.
+     */
+    inline bitboard getLegalTargets(int sq)
+    {
+        if (!m_legal_valid)
+            updateLegalMoves();
+        return m_targets[sq];
+    }
+    /**
+     * Carry out a move on the board core (bitboards and state), recording what is needed to take it back.
+     * The move must be legal, or at least pseudo-legal. There is no output and no allocation,
+     * and the piece objects (as returned by getPiece) are not touched.
+     * @param move: The move.
+     */
+    void makeMove(Move move);
+    /**
+     * Take back the last move carried out by makeMove.
+     */
+    void unmakeMove();
+    /**
+     * Check if a square is attacked by any piece of a side, working backwards from the square.
+     * @param sq: The square index.
+     * @param side: The attacking side.
+     * @return The result.
+     */
+    bool isSquareAttacked(int sq, int side);
+    /**
+     * Check if the current position has appeared a number of times, counting itself.
+     * Only positions since the last irreversible move (pawn move or capture) are scanned.
+     * @param times: Number of appearances needed.
+     * @return The result.
+     */
+    bool isRepetition(int times=3);
+    /**
+     * Check if neither side has enough material left to checkmate.
+     * @return The result.
+     */
+    bool isInsufficientMaterial();
+    /**
+     * Evaluate the current position statically by material, piece-square tables, mobility and king safety.
+     * @return The score in centipawns, positive if White is better.
+     */
+    int evaluate();
+    /**
+     * Get the material and piece-square part of the evaluation, which is kept up to date by every change of the core.
+     * @return The score in centipawns, positive if White is better.
+     */
+    inline int getMaterialScore()
+    {
+        return m_material[WHITE] - m_material[BLACK];
+    }
+    /**
+     * Get the number of plies since the last pawn move or capture.
+     * @return The halfmove clock.
+     */
+    inline int getHalfmoveClock()
+    {
+        return m_halfmove;
+    }
+    /**
+     * Get the fullmove number, starting from 1 and increased after each move of Black.
+     * @return The fullmove number.
+     */
+    inline int getFullmoveNumber()
+    {
+        return m_fullmove;
+    }
+    /**
+     * Get the Zobrist key of the current position, including the playing side, castling rights and en-passant file.
+     * While a pawn is waiting to be promoted, it is the key of the position before the pawn moves.
+     * @return The 64-bit key.
+     */
+    inline uint64_t getHash()
+    {
+        return m_hash;
+    }
+    /**
+     * Get the current playing side of the board core.
+     * @return The side.
+     */
+    inline int getSide()
+    {
+        return m_side;
+    }
     /**
      * Get a piece at a position.
      * @param pos: Designated position.
@@ -113,29 +381,119 @@ public:
     {
         return m_passant_pawn[side];
     }
+    /**
+     * Get the squares occupied by a type of pieces of a side.
+     * @param side: The side.
+     * @param type: The piece type.
+     * @return The bitboard.
+     */
+    inline bitboard getPieces(int side, int type)
+    {
+        return m_pieces[side][type];
+    }
+    /**
+     * Get the squares occupied by pieces of a side.
+     * @param side: The side.
+     * @return The bitboard.
+     */
+    inline bitboard getOccupied(int side)
+    {
+        return m_occupied[side];
+    }
+    /**
+     * Get the code of the piece on a square of the board core.
+     * @param sq: The square index.
+     * @return The piece code, NO_PIECE if the square is empty.
+     */
+    inline int getSquare(int sq)
+    {
+        return m_squares[sq];
+    }
+    /**
+     * Get the code of a piece in the board core.
+     * @param side: The side of the piece.
+     * @param type: The type of the piece.
+     * @return The piece code.
+     */
+    inline static int pieceCode(int side, int type)
+    {
+        return (side << 3) | (type + 1);
+    }
+    /**
+     * Get the side of a piece code.
+     * @param code: A piece code other than NO_PIECE.
+     * @return The side.
+     */
+    inline static int codeSide(int code)
+    {
+        return code >> 3;
+    }
+    /**
+     * Get the type of a piece code.
+     * @param code: A piece code other than NO_PIECE.
+     * @return The type.
+     */
+    inline static int codeType(int code)
+    {
+        return (code & 7) - 1;
+    }
 
 private:
     /**
-     * Try to submit a movement, and then rollback.
-     * If it is a valid movement, returning either the piece which is going to be taken,
-     * or the moving piece, if none other pieces will be take.
-     * Else, return nullptr.
-     * @param pos: The destination coordinate.
-     * @param piece: The moving piece.
-     * @return A pointer pointing to the moving piece or the taken piece.
+     * Check if the current player, just swapped by a movement, is in check, checkmate or stalemate.
      */
-    Piece* dryrunMove(coord pos, Piece* piece);
+    void updateStatus();
     /**
-     * Swap the current player and check if the current player is in check, checkmate or stalemate.
+     * Get the squares attacked by a piece on the current board.
+     * For sliding pieces, the first occupied square on each direction is included.
+     * @param sq: The square the piece is on.
+     * @param side: The side of the piece.
+     * @param type: The type of the piece.
+     * @return The bitboard of attacked squares.
+     */
+    bitboard attackSet(int sq, int side, int type);
+    /**
+     * Check if a castling of the current player is valid on the board core.
+     * @param king_src: King's square.
+     * @param king_dst: King's destination square.
+     * @return If it is valid.
      */
-    void swapPlayer();
+    bool castlingCheck(int king_src, int king_dst);
     /**
-     * Check if a castling is valid.
+     * Carry out a castling which has been checked to be valid.
      * @param king: The moving king.
      * @param king_dst: King's destination.
-     * @return If it is valid.
      */
-    bool castlingCheck(Piece *king, coord king_dst);
+    void castlingMove(Piece *king, coord king_dst);
+    /**
+     * Write the result of a submitted movement as text.
+     * @param result: The result.
+     * @param src: The source square as submitted.
+     * @param dst: The destination square as submitted.
+     */
+    void printMove(const MoveResult& result, int src, int dst);
+    /**
+     * Write the result of a submitted promotion as text.
+     * @param result: The result.
+     * @param type: The type as submitted.
+     */
+    void printPromotion(const MoveResult& result, int type);
+    /**
+     * Write a square as a two-char string (e.g. "A1").
+     * @param sq: The square index.
+     */
+    inline void printSquare(int sq)
+    {
+        m_ostr << (char) ('A' + (sq & 7)) << (char) ('1' + (sq >> 3));
+    }
+    /**
+     * Write the name of a piece, including side and type.
+     * @param code: The piece code.
+     */
+    inline void printPiece(int code)
+    {
+        m_ostr << getPlayer(codeSide(code)) << "'s " << Piece::TYPE_NAME[codeType(code)];
+    }
     /**
      * Check if a player is in check or checkmate.
      * @param side: The player needed to check.
@@ -143,11 +501,61 @@ private:
      */
     bool checkCheck(int side);
     /**
-     * Check if a player is in stalemate or checkmate.
-     * @param side: The player needed to check.
+     * Get the pieces of a side attacking a square, with the given squares occupied.
+     * @param sq: The square index.
+     * @param side: The attacking side.
+     * @param occupied: The occupied squares, which block the sliding pieces.
+     * @return The bitboard of the attacking pieces.
+     */
+    bitboard attackersTo(int sq, int side, bitboard occupied);
+    /**
+     * Check if a pseudo-legal move of the current player leaves its king safe.
+     * @param move: The move.
+     * @return The result.
+     */
+    bool legalCheck(Move move);
+    /**
+     * Check if the current player is in stalemate or checkmate, i.e. has no legal move.
      * @return The result.
      */
-    bool mateCheck(int side);
+    bool mateCheck();
+    /**
+     * Work out and keep the legal moves of the current player, and the squares each piece can move to.
+     */
+    void updateLegalMoves();
+    /**
+     * Generate a new piece object in a free slot of the board.
+     * @param side: The side of the piece.
+     * @param type: The type of the piece.
+     * @param pos: The position of the piece.
+     * @return The pointer pointing to the new piece.
+     */
+    Piece* createPiece(int side, int type, coord pos);
+    /**
+     * Destroy a piece object generated by createPiece, and free its slot.
+     * The slot freed last is the first to be taken again.
+     * @param piece: The piece.
+     */
+    void destroyPiece(Piece* piece);
+    /**
+     * Destroy all piece objects on the board, and free all slots.
+     */
+    void clearObjects();
+    /**
+     * Parse a FEN string into the board core, without any allocation.
+     * @param fen: The FEN string.
+     * @return If the string is valid, otherwise the board core is left unchanged.
+     */
+    bool parseFEN(const std::string& fen);
+    /**
+     * Write a position into the board core, with an empty history.
+     * @param position: The position, which is trusted to be valid.
+     */
+    void loadPosition(const Position& position);
+    /**
+     * Rebuild the piece objects from the board core.
+     */
+    void buildObjects();
     /**
      * Set a piece to a position.
      * Note, the function does not delete the previous piece at the position, if there is any.
@@ -158,6 +566,68 @@ private:
     {
         m_board[pos.first][pos.second] = piece;
     }
+    /**
+     * Get the Zobrist key of a piece on a square.
+     * @param code: The piece code.
+     * @param sq: The square.
+     * @return The key.
+     */
+    inline static uint64_t pieceKey(int code, int sq)
+    {
+        return PIECE_KEY[code][sq];
+    }
+    /**
+     * Get the Zobrist key of the castling rights and the en-passant file.
+     * @param castling: The castling rights.
+     * @param passant: The en-passant square, can be NO_SQUARE.
+     * @return The key.
+     */
+    inline static uint64_t stateKey(int castling, int passant)
+    {
+        return CASTLING_KEY[castling] ^ (passant == NO_SQUARE ? 0 : PASSANT_KEY[passant & 7]);
+    }
+    /**
+     * Put a piece on an empty square of the board core.
+     * @param sq: The square.
+     * @param code: The piece code.
+     */
+    inline void putPiece(int sq, int code)
+    {
+        m_pieces[codeSide(code)][codeType(code)] |= squareBit(sq);
+        m_occupied[codeSide(code)] |= squareBit(sq);
+        m_squares[sq] = (int8_t) code;
+        m_hash ^= pieceKey(code, sq);
+        m_material[codeSide(code)] += PIECE_SCORE[code][sq];
+    }
+    /**
+     * Remove the piece on a square of the board core.
+     * @param sq: The square, which must not be empty.
+     */
+    inline void removePiece(int sq)
+    {
+        int code = m_squares[sq];
+        m_pieces[codeSide(code)][codeType(code)] &= ~squareBit(sq);
+        m_occupied[codeSide(code)] &= ~squareBit(sq);
+        m_squares[sq] = NO_PIECE;
+        m_hash ^= pieceKey(code, sq);
+        m_material[codeSide(code)] -= PIECE_SCORE[code][sq];
+    }
+    /**
+     * Move the piece on a square of the board core to an empty square.
+     * @param src: The source square, which must not be empty.
+     * @param dst: The destination square, which must be empty.
+     */
+    inline void movePiece(int src, int dst)
+    {
+        int code = m_squares[src];
+        bitboard bits = squareBit(src) | squareBit(dst);
+        m_pieces[codeSide(code)][codeType(code)] ^= bits;
+        m_occupied[codeSide(code)] ^= bits;
+        m_squares[dst] = (int8_t) code;
+        m_squares[src] = NO_PIECE;
+        m_hash ^= pieceKey(code, src) ^ pieceKey(code, dst);
+        m_material[codeSide(code)] += PIECE_SCORE[code][dst] - PIECE_SCORE[code][src];
+    }
 
 public:
     // Number of sides(players).
@@ -167,7 +637,58 @@ public:
     // Size of the board.
     static const int ROW = 8, COL = 8;
     // Symbol for different status.
-    static const int NORMAL = 0, CHECK = 1, STALEMATE = 2, CHECKMATE = 3;
+    static const int NORMAL = 0, CHECK = 1, STALEMATE = 2, CHECKMATE = 3, DRAW = 4;
+    // Number of plies without pawn move or capture for a draw by the fifty-move rule.
+    static const int FIFTY_MOVE = 100;
+    // Piece code of an empty square.
+    static const int NO_PIECE = 0;
+    // Square index meaning no square.
+    static const int NO_SQUARE = -1;
+    // Castling rights, combinable.
+    static const int WHITE_KING_SIDE = 1, WHITE_QUEEN_SIDE = 2, BLACK_KING_SIDE = 4, BLACK_QUEEN_SIDE = 8;
+    static const int ALL_CASTLING = 15;
+    // Number of undo records preallocated.
+    static const int MAX_PLY = 1024;
+    // Kinds of moves to generate, combinable.
+    static const int CAPTURE_MOVES = 1, QUIET_MOVES = 2, ALL_MOVES = 3;
+    // Number of piece slots, as there is at most one piece on each square.
+    static const int SLOT_NUM = ROW * COL;
+    // Material value of each piece type.
+    static const int PIECE_VALUE[Piece::TYPE_NUM];
+
+private:
+    // Zobrist keys of each piece code on each square, castling rights, en-passant files and the black side.
+    static uint64_t PIECE_KEY[16][ROW * COL];
+    static uint64_t CASTLING_KEY[ALL_CASTLING + 1];
+    static uint64_t PASSANT_KEY[COL];
+    static uint64_t SIDE_KEY;
+    // Material value plus piece-square bonus of each piece code on each square.
+    static int PIECE_SCORE[16][ROW * COL];
+
+private:
+    /**
+     * Information needed to take back a move.
+     */
+    struct Undo
+    {
+        // The move.
+        Move move;
+        // Code of the taken piece, NO_PIECE if none.
+        int8_t captured;
+        // Castling rights before the move.
+        int8_t castling;
+        // En-passant square before the move.
+        int8_t passant;
+        // Halfmove clock before the move, in the same range as in Position.
+        uint16_t halfmove;
+        // Zobrist key before the move, which also serves as the history of positions.
+        uint64_t hash;
+    };
+
+    /**
+     * Storage of a piece object of any type.
+     */
+    typedef std::aligned_union<0, King, Rook, Bishop, Queen, Knight, Pawn>::type PieceSlot;
 
 private:
     // Current winner.
@@ -176,8 +697,36 @@ private:
     int m_side;
     // Current status for the current player.
     int m_status;
-    // The chess board containing piece pointers.
+    // The chess board containing piece pointers, which describes the game and is kept in sync with the core.
     Piece* m_board[ROW][COL];
+    // Bitboards of each piece type for each side.
+    bitboard m_pieces[SIDE][Piece::TYPE_NUM];
+    // Bitboards of all pieces for each side.
+    bitboard m_occupied[SIDE];
+    // Piece code on each square.
+    int8_t m_squares[ROW * COL];
+    // Castling rights still available.
+    int m_castling;
+    // The square a pawn can move to by an en-passant, NO_SQUARE if none.
+    int m_passant;
+    // Number of plies since the last pawn move or capture.
+    int m_halfmove;
+    // Number of the full move, increased after each move of Black.
+    int m_fullmove;
+    // Zobrist key of the position, updated along with every change of the core.
+    uint64_t m_hash;
+    // Material and piece-square sum of each side, updated along with every change of the core.
+    int m_material[SIDE];
+    // Undo records of the moves carried out, preallocated.
+    std::vector<Undo> m_undo;
+    // The move of the pawn waiting to be promoted, carried out on the core when the type is submitted.
+    Move m_promotion_move;
+    // Storage of the piece objects, so that no piece is allocated on the heap.
+    PieceSlot m_slots[SLOT_NUM];
+    // Indices of the free slots, used as a stack.
+    int8_t m_free[SLOT_NUM];
+    // Number of free slots.
+    int m_free_num;
     // Pointers to the kings.
     Piece* m_king[SIDE];
     // Pointers to the pawns which can be taken by an en-passent, if any.
@@ -186,6 +735,14 @@ private:
     Piece* m_promotion_pawn[SIDE];
     // Reference of output stream.
     std::ostream& m_ostr;
+    // If the results are written to the output stream.
+    bool m_verbose;
+    // Legal moves of the current player.
+    MoveList m_legal;
+    // Squares each piece can legally move to, in the same position.
+    bitboard m_targets[ROW * COL];
+    // If the legal moves are for the current position, cleared by every change of the board core.
+    bool m_legal_valid;
 };
 
 #endif
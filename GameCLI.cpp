@@ -13,8 +13,14 @@
 ***********************************************************************/
 
 #include "ChessBoard.h"
+#include "NNUE.h"
+#include "Search.h"
+#include "TransTable.h"
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 
@@ -41,6 +47,21 @@ const char* HELP = ""
     "                      The type must be one of the following four:\n"
     "                      queen, rook, knight, bishop.\n"
     "\n"
+    " - go depth <N>:      Let the computer search N plies and play the best move.\n"
+    "\n"
+    " - go movetime <MS>:  Let the computer search for MS milliseconds and play the best move.\n"
+    "\n"
+    " - threads <N>:       Set the number of threads the computer searches with.\n"
+    "\n"
+    " - hash <MB> [huge]:  Resize the transposition table of the computer, optionally with huge pages.\n"
+    "\n"
+    " - fen [FEN]:         Show the FEN of the board, or set up the board from FEN.\n"
+    "                      e.g. fen 4k3/8/8/8/8/8/4P3/4K3 w - - 0 1.\n"
+    "\n"
+    " - eval:              Show the static evaluation of the board, positive if White is better.\n"
+    "\n"
+    " - nnue <FILE>:       Load a network from FILE, which the computer then evaluates with.\n"
+    "\n"
     " - help:              Show available options.\n"
     "\n"
     " - restart:           Restart the game.\n"
@@ -58,6 +79,10 @@ int main()
 
     // Create an object for the core chess game simulation.
     ChessBoard board;
+    TransTable table;
+    NNUE network;
+    bool network_loaded = false;
+    int threads = 1;
     cout << endl;
     board.drawBoard();
     cout << endl;
@@ -79,11 +104,140 @@ int main()
         {
             cout << NEW_GAME << endl;
             board.resetBoard();
+            table.clear();
+            cout << endl;
+            board.drawBoard();
+            cout << endl;
+        }
+
+        // Let the computer play.
+        else if (src == "go")
+        {
+            // The arguments are parsed from the rest of the line, so that a bad one is not taken as the next command.
+            string line, limit;
+            int value = 0;
+            getline(cin, line);
+            istringstream args(line);
+            args >> limit >> value;
+            if ((limit != "depth" && limit != "movetime") || value <= 0)
+            {
+                cout << "Usage: go depth <N> or go movetime <MS>" << endl << endl;
+                continue;
+            }
+
+            // The board core is still before the pawn move, so the promotion has to be finished first.
+            if (board.isPromoting())
+            {
+                cout << "Promote the pawn first, to rook, knight, bishop or queen" << endl << endl;
+                continue;
+            }
+
+            // Search on the board core, and submit the best move through the interface like a player.
+            Search search(board, &table);
+            search.setThreads(threads);
+            search.setNetwork(network_loaded ? &network : nullptr);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            Move move = limit == "depth" ? search.think(value) : search.think(0, value);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << "Searched " << search.getNodes() << " nodes in " << seconds << " s, ";
+            cout << (uint64_t) (seconds > 0 ? search.getNodes() / seconds : 0) << " nodes/s" << endl;
+            if (threads > 1)
+                for (size_t i = 0; i < search.getThreadNodes().size(); i++)
+                    cout << "  Thread " << i << ": " << search.getThreadNodes()[i] << " nodes" << endl;
+            if (move.isNull())
+            {
+                cout << "There is no move to play!" << endl << endl;
+                continue;
+            }
+            cout << "Best move: " << move.str() << endl << endl;
+            board.submitMove(move);
             cout << endl;
             board.drawBoard();
             cout << endl;
         }
 
+        // Set the number of threads.
+        else if (src == "threads")
+        {
+            cin >> threads;
+            if (!cin || threads < 1)
+            {
+                cin.clear();
+                threads = 1;
+                cout << "Usage: threads <N>" << endl << endl;
+                continue;
+            }
+            cout << "Searching with " << threads << " threads" << endl << endl;
+        }
+
+        // Resize the transposition table.
+        else if (src == "hash")
+        {
+            string line;
+            getline(cin, line);
+            int mb = atoi(line.c_str());
+            if (mb <= 0)
+            {
+                cout << "Usage: hash <MB> [huge]" << endl << endl;
+                continue;
+            }
+            table.resize(mb, line.find("huge") != string::npos);
+            cout << "Transposition table: " << (table.getSize() >> 20) << " MB";
+            cout << (table.isHugePages() ? ", huge pages" : "") << endl << endl;
+        }
+
+        // Show or load the FEN.
+        else if (src == "fen")
+        {
+            string fen;
+            getline(cin, fen);
+            fen.erase(0, fen.find_first_not_of(' '));
+            if (fen.empty())
+                cout << board.getFEN() << endl << endl;
+            else if (board.setFEN(fen))
+            {
+                table.clear();
+                cout << endl;
+                board.drawBoard();
+                cout << endl;
+            }
+            else
+                cout << endl;
+        }
+
+        // Show the static evaluation.
+        else if (src == "eval")
+        {
+            int score = board.evaluate();
+            cout << "Evaluation: " << (score > 0 ? "+" : "") << score << " centipawns (material and piece-square ";
+            cout << board.getMaterialScore() << ")" << endl;
+            if (network_loaded)
+            {
+                Accumulator acc;
+                Position position = board.getPosition();
+                network.refresh(acc, position.squares);
+                score = network.evaluate(acc, position.side);
+                cout << "Network: " << (position.side == ChessBoard::WHITE ? score : -score) << " centipawns" << endl;
+            }
+            cout << endl;
+        }
+
+        // Load a network and evaluate with it.
+        else if (src == "nnue")
+        {
+            string path;
+            getline(cin, path);
+            path.erase(0, path.find_first_not_of(' '));
+            if (!network.load(path))
+            {
+                cout << "Cannot load a network from \"" << path << "\"" << endl << endl;
+                continue;
+            }
+            network_loaded = true;
+            table.clear();
+            cout << "Network loaded, running on " << NNUE::SIMD_NAME[network.getSimd()] << endl << endl;
+        }
+
         // Show help message.
         else if (src == "help")
             cout << HELP << endl;
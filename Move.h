@@ -0,0 +1,256 @@
+/***********************************************************************
+* Move.h Declaration of compact move and move list for chess game      *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#ifndef _MOVE_H_
+#define _MOVE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "Piece.h"
+
+
+/**
+ * A movement packed into 16 bits.
+ * Bits 0 ~ 5 hold the source square, bits 6 ~ 11 hold the destination square, bits 12 ~ 15 hold the flag.
+ */
+class Move
+{
+public:
+    /**
+     * Constructor for an empty (null) move.
+     */
+    Move():
+        m_data(0)
+    {
+    }
+    /**
+     * Constructor.
+     * @param src: The source square.
+     * @param dst: The destination square.
+     * @param flag: One of the flags below.
+     */
+    Move(int src, int dst, int flag=QUIET):
+        m_data((uint16_t) (src | (dst << 6) | (flag << 12)))
+    {
+    }
+    /**
+     * Get the source square.
+     * @return The square index.
+     */
+    inline int getSrc() const
+    {
+        return m_data & 0x3f;
+    }
+    /**
+     * Get the destination square.
+     * @return The square index.
+     */
+    inline int getDst() const
+    {
+        return (m_data >> 6) & 0x3f;
+    }
+    /**
+     * Get the flag of the move.
+     * @return The flag.
+     */
+    inline int getFlag() const
+    {
+        return m_data >> 12;
+    }
+    /**
+     * Check if the move takes a piece, including en-passant.
+     * @return The result.
+     */
+    inline bool isCapture() const
+    {
+        return (getFlag() & CAPTURE) != 0;
+    }
+    /**
+     * Check if the move is a pawn promotion.
+     * @return The result.
+     */
+    inline bool isPromotion() const
+    {
+        return (getFlag() & PROMOTION) != 0;
+    }
+    /**
+     * Check if the move is a castling.
+     * @return The result.
+     */
+    inline bool isCastling() const
+    {
+        return getFlag() == KING_CASTLE || getFlag() == QUEEN_CASTLE;
+    }
+    /**
+     * Get the type the pawn is promoted to.
+     * @return One of Piece::KNIGHT, Piece::BISHOP, Piece::ROOK and Piece::QUEEN, only meaningful for promotions.
+     */
+    inline int getPromotion() const
+    {
+        switch (getFlag() & 3)
+        {
+            case 0:
+                return Piece::KNIGHT;
+            case 1:
+                return Piece::BISHOP;
+            case 2:
+                return Piece::ROOK;
+            default:
+                return Piece::QUEEN;
+        }
+    }
+    /**
+     * Get the promotion flag for a type.
+     * @param type: One of Piece::KNIGHT, Piece::BISHOP, Piece::ROOK and Piece::QUEEN.
+     * @return The flag, without the capture bit.
+     */
+    inline static int promotionFlag(int type)
+    {
+        switch (type)
+        {
+            case Piece::KNIGHT:
+                return PROMOTE_KNIGHT;
+            case Piece::BISHOP:
+                return PROMOTE_BISHOP;
+            case Piece::ROOK:
+                return PROMOTE_ROOK;
+            default:
+                return PROMOTE_QUEEN;
+        }
+    }
+    /**
+     * Check if it is a null move.
+     * @return The result.
+     */
+    inline bool isNull() const
+    {
+        return m_data == 0;
+    }
+    /**
+     * Get the raw 16-bit representation.
+     * @return The packed move.
+     */
+    inline uint16_t getData() const
+    {
+        return m_data;
+    }
+    /**
+     * Get a readable form of the move (e.g. "E2E4", "A7A8Q").
+     * @return The string.
+     */
+    std::string str() const
+    {
+        const char str[5] = {(char) ('A' + (getSrc() & 7)), (char) ('1' + (getSrc() >> 3)),
+                             (char) ('A' + (getDst() & 7)), (char) ('1' + (getDst() >> 3)), "NBRQ"[getFlag() & 3]};
+        return std::string(str, isPromotion() ? 5 : 4);
+    }
+    inline bool operator==(const Move& other) const
+    {
+        return m_data == other.m_data;
+    }
+    inline bool operator!=(const Move& other) const
+    {
+        return m_data != other.m_data;
+    }
+
+public:
+    // Flags of a move, capture and promotion flags are combinable.
+    static const int QUIET = 0, DOUBLE_PUSH = 1, KING_CASTLE = 2, QUEEN_CASTLE = 3;
+    static const int CAPTURE = 4, EN_PASSANT = 5;
+    static const int PROMOTION = 8;
+    static const int PROMOTE_KNIGHT = 8, PROMOTE_BISHOP = 9, PROMOTE_ROOK = 10, PROMOTE_QUEEN = 11;
+
+private:
+    // The packed move.
+    uint16_t m_data;
+};
+
+/**
+ * A fixed-capacity list of moves, which is expected to live on the stack.
+ */
+class MoveList
+{
+public:
+    /**
+     * Constructor.
+     */
+    MoveList():
+        m_size(0)
+    {
+    }
+    /**
+     * Append a move to the list.
+     * @param move: The move.
+     */
+    inline void push(Move move)
+    {
+        m_moves[m_size++] = move;
+    }
+    /**
+     * Remove all moves.
+     */
+    inline void clear()
+    {
+        m_size = 0;
+    }
+    /**
+     * Get the number of moves in the list.
+     * @return The size.
+     */
+    inline int size() const
+    {
+        return m_size;
+    }
+    /**
+     * Check if a move is in the list.
+     * @param move: The move.
+     * @return The result.
+     */
+    inline bool contains(Move move) const
+    {
+        for (int i = 0; i < m_size; i++)
+            if (m_moves[i] == move)
+                return true;
+        return false;
+    }
+    inline Move& operator[](int i)
+    {
+        return m_moves[i];
+    }
+    inline const Move& operator[](int i) const
+    {
+        return m_moves[i];
+    }
+    inline const Move* begin() const
+    {
+        return m_moves;
+    }
+    inline const Move* end() const
+    {
+        return m_moves + m_size;
+    }
+
+public:
+    // Capacity of the list, the maximum number of legal moves in a chess position is 218.
+    static const int CAPACITY = 256;
+
+private:
+    // The moves.
+    Move m_moves[CAPACITY];
+    // Number of moves.
+    int m_size;
+};
+
+#endif
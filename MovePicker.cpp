@@ -0,0 +1,150 @@
+/***********************************************************************
+* MovePicker.cpp Implementation of staged move ordering for search     *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#include "MovePicker.h"
+
+using namespace std;
+
+
+MovePicker::MovePicker(ChessBoard& board, Move hash_move, const Move* killers, const HistoryTable* history,
+    bool quiesce):
+    m_board(board), m_hash_move(hash_move), m_history(history), m_quiesce(quiesce),
+    m_stage(quiesce ? GENERATE_CAPTURES : HASH), m_index(0), m_killer_index(0), m_bad_index(0)
+{
+    for (int i = 0; i < KILLER_NUM; i++)
+        m_killers[i] = killers && !quiesce ? killers[i] : Move();
+    if (quiesce)
+        m_hash_move = Move();
+}
+
+Move MovePicker::next()
+{
+    while (m_stage != DONE)
+    {
+        if (m_stage == HASH)
+        {
+            m_stage = GENERATE_CAPTURES;
+            if (!m_hash_move.isNull() && m_board.isLegalMove(m_hash_move))
+                return m_hash_move;
+            m_hash_move = Move();
+        }
+
+        // Most valuable victim first, and then least valuable attacker first.
+        // Promotions add the value of the new piece.
+        else if (m_stage == GENERATE_CAPTURES)
+        {
+            m_board.generateLegalMoves(m_list, ChessBoard::CAPTURE_MOVES);
+            for (int i = 0; i < m_list.size(); i++)
+            {
+                Move move = m_list[i];
+                m_scores[i] = 0;
+                if (move.isCapture())
+                {
+                    int victim = move.getFlag() == Move::EN_PASSANT ? Piece::PAWN :
+                        ChessBoard::codeType(m_board.getSquare(move.getDst()));
+                    int attacker = ChessBoard::codeType(m_board.getSquare(move.getSrc()));
+                    m_scores[i] = ChessBoard::PIECE_VALUE[victim] * 10 - ChessBoard::PIECE_VALUE[attacker] / 100 + 1;
+                }
+                if (move.isPromotion())
+                    m_scores[i] += ChessBoard::PIECE_VALUE[move.getPromotion()];
+            }
+            m_index = 0;
+            m_stage = GOOD_CAPTURES;
+        }
+
+        // Captures losing material are put off, or dropped in the quiescence search.
+        else if (m_stage == GOOD_CAPTURES)
+        {
+            if (m_index == m_list.size())
+            {
+                m_stage = m_quiesce ? DONE : KILLERS;
+                continue;
+            }
+            Move move = pickBest();
+            if (move == m_hash_move)
+                continue;
+            if (move.isCapture() && m_board.see(move) < 0)
+            {
+                if (!m_quiesce)
+                    m_bad.push(move);
+                continue;
+            }
+            return move;
+        }
+
+        // A killer comes from another position, so it is only tried if it is a legal quiet move here.
+        else if (m_stage == KILLERS)
+        {
+            if (m_killer_index == KILLER_NUM)
+            {
+                m_stage = GENERATE_QUIETS;
+                continue;
+            }
+            Move move = m_killers[m_killer_index++];
+            if (!move.isNull() && move != m_hash_move && m_board.getSquare(move.getDst()) == ChessBoard::NO_PIECE &&
+                m_board.isLegalMove(move))
+                return move;
+        }
+
+        else if (m_stage == GENERATE_QUIETS)
+        {
+            m_board.generateLegalMoves(m_list, ChessBoard::QUIET_MOVES);
+            int side = m_board.getSide();
+            for (int i = 0; i < m_list.size(); i++)
+                m_scores[i] = m_history ? (*m_history)[side][m_list[i].getSrc()][m_list[i].getDst()] : 0;
+            m_index = 0;
+            m_stage = QUIETS;
+        }
+
+        else if (m_stage == QUIETS)
+        {
+            if (m_index == m_list.size())
+            {
+                m_stage = BAD_CAPTURES;
+                continue;
+            }
+            Move move = pickBest();
+            if (move != m_hash_move && !isKiller(move))
+                return move;
+        }
+
+        else if (m_stage == BAD_CAPTURES)
+        {
+            if (m_bad_index == m_bad.size())
+            {
+                m_stage = DONE;
+                continue;
+            }
+            return m_bad[m_bad_index++];
+        }
+    }
+    return Move();
+}
+
+Move MovePicker::pickBest()
+{
+    // One pass of selection sort, which is cheaper than a full sort when a cutoff comes early.
+    int best = m_index;
+    for (int i = m_index + 1; i < m_list.size(); i++)
+        if (m_scores[i] > m_scores[best])
+            best = i;
+    Move move = m_list[best];
+    int score = m_scores[best];
+    m_list[best] = m_list[m_index];
+    m_scores[best] = m_scores[m_index];
+    m_list[m_index] = move;
+    m_scores[m_index] = score;
+    m_index++;
+    return move;
+}
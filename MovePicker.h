@@ -0,0 +1,103 @@
+/***********************************************************************
+* MovePicker.h Declaration of staged move ordering for chess search    *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#ifndef _MOVE_PICKER_H_
+#define _MOVE_PICKER_H_
+
+#include "ChessBoard.h"
+#include "Move.h"
+
+
+// Scores of quiet moves of each side by source and destination square, raised by the cutoffs they cause.
+typedef int HistoryTable[ChessBoard::SIDE][ChessBoard::ROW * ChessBoard::COL][ChessBoard::ROW * ChessBoard::COL];
+
+/**
+ * Hands out the legal moves of a position one by one, the likely best ones first, in stages:
+ * the hash move, the captures which do not lose material (most valuable victim by least valuable attacker first),
+ * the killer moves, the other quiet moves by their history scores, and last the captures which lose material.
+ * Each kind of move is only generated when its stage is reached, so a cutoff on an early move saves the rest.
+ * The list of a stage is sorted lazily, by picking the best of the rest for each move handed out.
+ */
+class MovePicker
+{
+public:
+    /**
+     * Constructor.
+     * @param board: The board, which must stay in the same position while moves are picked.
+     * @param hash_move: The move to try first, can be a null move or even an illegal one, which is then skipped.
+     * @param killers: KILLER_NUM quiet moves which caused cutoffs in sibling positions, can be nullptr.
+     * @param history: The history scores of quiet moves, can be nullptr.
+     * @param quiesce: Whether to hand out only the captures and promotions which do not lose material.
+     */
+    MovePicker(ChessBoard& board, Move hash_move, const Move* killers, const HistoryTable* history,
+        bool quiesce=false);
+    /**
+     * Get the next move.
+     * @return The move, a null move if there is none left.
+     */
+    Move next();
+
+public:
+    // Number of killer moves of each ply.
+    static const int KILLER_NUM = 2;
+
+private:
+    /**
+     * Take the move with the highest score out of the rest of the current list.
+     * @return The move.
+     */
+    Move pickBest();
+    /**
+     * Check if a move is one of the killer moves.
+     * @param move: The move.
+     * @return The result.
+     */
+    inline bool isKiller(Move move)
+    {
+        for (int i = 0; i < KILLER_NUM; i++)
+            if (m_killers[i] == move)
+                return true;
+        return false;
+    }
+
+private:
+    // Stages, in the order they are gone through.
+    static const int HASH = 0, GENERATE_CAPTURES = 1, GOOD_CAPTURES = 2, KILLERS = 3, GENERATE_QUIETS = 4, QUIETS = 5;
+    static const int BAD_CAPTURES = 6, DONE = 7;
+
+private:
+    // The board.
+    ChessBoard& m_board;
+    // The move to try first.
+    Move m_hash_move;
+    // The killer moves, null moves if none.
+    Move m_killers[KILLER_NUM];
+    // The history scores, can be nullptr.
+    const HistoryTable* m_history;
+    // Whether only good captures and promotions are handed out.
+    bool m_quiesce;
+    // Current stage.
+    int m_stage;
+    // Moves of the current stage, their scores, and the index of the next one.
+    MoveList m_list;
+    int m_scores[MoveList::CAPACITY];
+    int m_index;
+    // Index of the next killer move.
+    int m_killer_index;
+    // Captures losing material, put off to the last stage, and the index of the next one.
+    MoveList m_bad;
+    int m_bad_index;
+};
+
+#endif
@@ -0,0 +1,432 @@
+/***********************************************************************
+* NNUE.cpp Implementation of neural network evaluation for chess       *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#include "NNUE.h"
+#include "ChessBoard.h"
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86
+#endif
+
+using namespace std;
+
+
+const char* NNUE::SIMD_NAME[3] = {"Scalar", "SSE2", "AVX2"};
+
+// Magic number and version at the head of a network file.
+static const char FILE_MAGIC[4] = {'T', 'C', 'N', 'N'};
+static const uint32_t FILE_VERSION = 1;
+// Size of a network file in bytes: the header, and the weights and biases of each layer.
+static const size_t FILE_SIZE = sizeof(FILE_MAGIC) + 4 * 4 +
+    (NNUE::INPUT * NNUE::HIDDEN + NNUE::HIDDEN) * 2 + NNUE::DENSE * 2 * NNUE::HIDDEN + NNUE::DENSE * 4 + NNUE::DENSE + 4;
+
+// A column of zeros, added or subtracted where an update has only one side.
+static const int16_t ZERO_COLUMN[NNUE::HIDDEN] = {};
+
+/**
+ * Read a little-endian integer from a buffer, and move past it.
+ * @param p: The buffer position.
+ * @param bytes: Size of the integer, 1 ~ 4.
+ * @return The integer, to be cast into a signed type of its size.
+ */
+static uint32_t readLittle(const unsigned char*& p, int bytes)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; i++)
+        v |= (uint32_t) p[i] << (8 * i);
+    p += bytes;
+    return v;
+}
+
+/**
+ * Append a little-endian integer to a buffer.
+ * @param out: The buffer.
+ * @param v: The integer, cast from a signed type of its size.
+ * @param bytes: Size of the integer, 1 ~ 4.
+ */
+static void writeLittle(string& out, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        out += (char) (v >> (8 * i));
+}
+
+/**
+ * Subtract a weight column from an accumulator half and add another, with 16-bit wrapping like the vector versions.
+ * @param acc: The accumulator half.
+ * @param sub: The column to subtract.
+ * @param add: The column to add.
+ */
+static void updateScalar(int16_t* acc, const int16_t* sub, const int16_t* add)
+{
+    for (int i = 0; i < NNUE::HIDDEN; i++)
+        acc[i] = (int16_t) (uint16_t) ((uint16_t) acc[i] - (uint16_t) sub[i] + (uint16_t) add[i]);
+}
+
+/**
+ * Clip both accumulator halves into 0 ~ 127, the half of the side to move first.
+ * @param acc: The accumulator.
+ * @param side: The side to move.
+ * @param out: The 2 * HIDDEN clipped values.
+ */
+static void clipScalar(const Accumulator& acc, int side, uint8_t* out)
+{
+    for (int h = 0; h < 2; h++)
+        for (int i = 0; i < NNUE::HIDDEN; i++)
+        {
+            int v = acc.values[side ^ h][i];
+            out[h * NNUE::HIDDEN + i] = (uint8_t) (v < 0 ? 0 : v > 127 ? 127 : v);
+        }
+}
+
+/**
+ * Get the dot product of the clipped values with a row of the dense layer.
+ * @param in: The 2 * HIDDEN clipped values.
+ * @param row: The row of weights.
+ * @return The sum.
+ */
+static int32_t dotScalar(const uint8_t* in, const int8_t* row)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < 2 * NNUE::HIDDEN; i++)
+        sum += in[i] * row[i];
+    return sum;
+}
+
+#ifdef NNUE_X86
+__attribute__((target("sse2"))) static void updateSse2(int16_t* acc, const int16_t* sub, const int16_t* add)
+{
+    for (int i = 0; i < NNUE::HIDDEN; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) (acc + i));
+        v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i*) (sub + i)));
+        v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i*) (add + i)));
+        _mm_storeu_si128((__m128i*) (acc + i), v);
+    }
+}
+
+__attribute__((target("sse2"))) static void clipSse2(const Accumulator& acc, int side, uint8_t* out)
+{
+    // Saturate into 0 ~ 255 while packing to bytes, and then cut down to 127.
+    const __m128i top = _mm_set1_epi8(127);
+    for (int h = 0; h < 2; h++)
+    {
+        const int16_t* half = acc.values[side ^ h];
+        for (int i = 0; i < NNUE::HIDDEN; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*) (half + i));
+            __m128i b = _mm_loadu_si128((const __m128i*) (half + i + 8));
+            _mm_storeu_si128((__m128i*) (out + h * NNUE::HIDDEN + i), _mm_min_epu8(_mm_packus_epi16(a, b), top));
+        }
+    }
+}
+
+__attribute__((target("sse2"))) static int32_t dotSse2(const uint8_t* in, const int8_t* row)
+{
+    // Widen both operands to 16 bits, the weights with their signs, and sum the products in pairs.
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (int i = 0; i < 2 * NNUE::HIDDEN; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*) (in + i));
+        __m128i w = _mm_loadu_si128((const __m128i*) (row + i));
+        __m128i wlo = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8), whi = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(x, zero), wlo));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(x, zero), whi));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2"))) static void updateAvx2(int16_t* acc, const int16_t* sub, const int16_t* add)
+{
+    for (int i = 0; i < NNUE::HIDDEN; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (acc + i));
+        v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i*) (sub + i)));
+        v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i*) (add + i)));
+        _mm256_storeu_si256((__m256i*) (acc + i), v);
+    }
+}
+
+__attribute__((target("avx2"))) static void clipAvx2(const Accumulator& acc, int side, uint8_t* out)
+{
+    // Packing works within each 128-bit lane, so the quadwords are put back in order afterwards.
+    const __m256i top = _mm256_set1_epi8(127);
+    for (int h = 0; h < 2; h++)
+    {
+        const int16_t* half = acc.values[side ^ h];
+        for (int i = 0; i < NNUE::HIDDEN; i += 32)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*) (half + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*) (half + i + 16));
+            __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+            _mm256_storeu_si256((__m256i*) (out + h * NNUE::HIDDEN + i), _mm256_min_epu8(v, top));
+        }
+    }
+}
+
+__attribute__((target("avx2"))) static int32_t dotAvx2(const uint8_t* in, const int8_t* row)
+{
+    // Products of unsigned and signed bytes are summed in pairs into 16 bits, which cannot saturate as the inputs
+    // are at most 127, and then in pairs again into 32 bits.
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < 2 * NNUE::HIDDEN; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (in + i));
+        __m256i w = _mm256_loadu_si256((const __m256i*) (row + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+    return _mm_cvtsi128_si32(s);
+}
+#endif
+
+/**
+ * Update an accumulator half by the instruction set in use.
+ * @param simd: The instruction set.
+ * @param acc: The accumulator half.
+ * @param sub: The column to subtract.
+ * @param add: The column to add.
+ */
+static inline void update(int simd, int16_t* acc, const int16_t* sub, const int16_t* add)
+{
+#ifdef NNUE_X86
+    if (simd == NNUE::AVX2)
+        updateAvx2(acc, sub, add);
+    else if (simd == NNUE::SSE2)
+        updateSse2(acc, sub, add);
+    else
+#endif
+        updateScalar(acc, sub, add);
+}
+
+NNUE::NNUE():
+    m_simd(SCALAR), m_input_weights(INPUT * HIDDEN), m_input_biases(HIDDEN), m_dense_weights(DENSE * 2 * HIDDEN),
+    m_dense_biases(DENSE), m_output_weights(DENSE), m_output_bias(0)
+{
+    if (!setSimd(AVX2))
+        setSimd(SSE2);
+}
+
+/*
+ * The file is the header (magic, version and the three layer sizes as 32-bit integers),
+ * followed by the input weights and biases, the dense weights and biases, and the output weights and bias,
+ * each array in the order they are stored here, all in little-endian whatever the byte order of the host.
+ * A file of any other size is rejected before anything is read, so it is never taken in half.
+ */
+bool NNUE::load(const string& path)
+{
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file || file.tellg() != (streamoff) FILE_SIZE)
+        return false;
+    vector<unsigned char> data(FILE_SIZE);
+    file.seekg(0);
+    if (!file.read((char*) data.data(), data.size()) || file.peek() != EOF)
+        return false;
+
+    const unsigned char* p = data.data() + sizeof(FILE_MAGIC);
+    if (memcmp(data.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) || readLittle(p, 4) != FILE_VERSION ||
+        readLittle(p, 4) != (uint32_t) INPUT || readLittle(p, 4) != (uint32_t) HIDDEN ||
+        readLittle(p, 4) != (uint32_t) DENSE)
+        return false;
+
+    for (int16_t& w: m_input_weights)
+        w = (int16_t) readLittle(p, 2);
+    for (int16_t& b: m_input_biases)
+        b = (int16_t) readLittle(p, 2);
+    for (int8_t& w: m_dense_weights)
+        w = (int8_t) readLittle(p, 1);
+    for (int32_t& b: m_dense_biases)
+        b = (int32_t) readLittle(p, 4);
+    for (int8_t& w: m_output_weights)
+        w = (int8_t) readLittle(p, 1);
+    m_output_bias = (int32_t) readLittle(p, 4);
+    return true;
+}
+
+bool NNUE::save(const string& path)
+{
+    string data(FILE_MAGIC, sizeof(FILE_MAGIC));
+    data.reserve(FILE_SIZE);
+    writeLittle(data, FILE_VERSION, 4);
+    writeLittle(data, (uint32_t) INPUT, 4);
+    writeLittle(data, (uint32_t) HIDDEN, 4);
+    writeLittle(data, (uint32_t) DENSE, 4);
+    for (int16_t w: m_input_weights)
+        writeLittle(data, (uint16_t) w, 2);
+    for (int16_t b: m_input_biases)
+        writeLittle(data, (uint16_t) b, 2);
+    for (int8_t w: m_dense_weights)
+        writeLittle(data, (uint8_t) w, 1);
+    for (int32_t b: m_dense_biases)
+        writeLittle(data, (uint32_t) b, 4);
+    for (int8_t w: m_output_weights)
+        writeLittle(data, (uint8_t) w, 1);
+    writeLittle(data, (uint32_t) m_output_bias, 4);
+
+    ofstream file(path, ios::binary);
+    file.write(data.data(), data.size());
+    return (bool) file.flush();
+}
+
+/*
+ * The ranges keep an accumulator of 32 pieces far from overflowing, and leave some of the dense outputs unclipped.
+ */
+void NNUE::randomize(uint64_t seed)
+{
+    for (int16_t& w: m_input_weights)
+    {
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        w = (int16_t) ((seed * 0x2545f4914f6cdd1dULL) >> 58) - 32;
+    }
+    for (int16_t& b: m_input_biases)
+    {
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        b = (int16_t) ((seed * 0x2545f4914f6cdd1dULL) >> 57) - 32;
+    }
+    for (int8_t& w: m_dense_weights)
+    {
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        w = (int8_t) ((int) ((seed * 0x2545f4914f6cdd1dULL) >> 59) - 16);
+    }
+    for (int32_t& b: m_dense_biases)
+    {
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        b = (int32_t) ((seed * 0x2545f4914f6cdd1dULL) >> 53) - 1024;
+    }
+    for (int8_t& w: m_output_weights)
+    {
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        w = (int8_t) ((int) ((seed * 0x2545f4914f6cdd1dULL) >> 58) - 32);
+    }
+    m_output_bias = 0;
+}
+
+bool NNUE::setSimd(int simd)
+{
+    if (!cpuHasSimd(simd))
+        return false;
+    m_simd = simd;
+    return true;
+}
+
+void NNUE::refresh(Accumulator& acc, const int8_t* squares) const
+{
+    for (int view = 0; view < 2; view++)
+    {
+        memcpy(acc.values[view], m_input_biases.data(), sizeof(acc.values[view]));
+        for (int sq = 0; sq < 64; sq++)
+            if (squares[sq])
+                update(m_simd, acc.values[view], ZERO_COLUMN,
+                    &m_input_weights[inputIndex(view, squares[sq], sq) * HIDDEN]);
+    }
+}
+
+void NNUE::addPiece(Accumulator& acc, int code, int sq) const
+{
+    for (int view = 0; view < 2; view++)
+        update(m_simd, acc.values[view], ZERO_COLUMN, &m_input_weights[inputIndex(view, code, sq) * HIDDEN]);
+}
+
+void NNUE::removePiece(Accumulator& acc, int code, int sq) const
+{
+    for (int view = 0; view < 2; view++)
+        update(m_simd, acc.values[view], &m_input_weights[inputIndex(view, code, sq) * HIDDEN], ZERO_COLUMN);
+}
+
+void NNUE::movePiece(Accumulator& acc, int code, int src, int dst) const
+{
+    for (int view = 0; view < 2; view++)
+        update(m_simd, acc.values[view], &m_input_weights[inputIndex(view, code, src) * HIDDEN],
+            &m_input_weights[inputIndex(view, code, dst) * HIDDEN]);
+}
+
+/*
+ * The pieces are changed as by ChessBoard::makeMove: the piece taken, the piece moved or promoted,
+ * and the rook of a castling.
+ */
+void NNUE::applyMove(const Accumulator& acc, Accumulator& next, ChessBoard& board, Move move) const
+{
+    int src = move.getSrc(), dst = move.getDst(), flag = move.getFlag();
+    int code = board.getSquare(src), side = ChessBoard::codeSide(code);
+    next = acc;
+    if (flag == Move::EN_PASSANT)
+    {
+        int tar = side ? dst + ChessBoard::COL : dst - ChessBoard::COL;
+        removePiece(next, board.getSquare(tar), tar);
+    }
+    else if (move.isCapture())
+        removePiece(next, board.getSquare(dst), dst);
+
+    if (move.isPromotion())
+    {
+        removePiece(next, code, src);
+        addPiece(next, ChessBoard::pieceCode(side, move.getPromotion()), dst);
+    }
+    else
+        movePiece(next, code, src, dst);
+    if (flag == Move::KING_CASTLE)
+        movePiece(next, board.getSquare(dst + 1), dst + 1, dst - 1);
+    else if (flag == Move::QUEEN_CASTLE)
+        movePiece(next, board.getSquare(dst - 2), dst - 2, dst + 1);
+}
+
+int NNUE::evaluate(const Accumulator& acc, int side) const
+{
+    uint8_t in[2 * HIDDEN];
+    int32_t (*dot)(const uint8_t*, const int8_t*) = dotScalar;
+#ifdef NNUE_X86
+    if (m_simd == AVX2)
+    {
+        clipAvx2(acc, side, in);
+        dot = dotAvx2;
+    }
+    else if (m_simd == SSE2)
+    {
+        clipSse2(acc, side, in);
+        dot = dotSse2;
+    }
+    else
+#endif
+        clipScalar(acc, side, in);
+
+    int32_t out = m_output_bias;
+    for (int i = 0; i < DENSE; i++)
+    {
+        int32_t v = (m_dense_biases[i] + dot(in, &m_dense_weights[i * 2 * HIDDEN])) >> DENSE_SHIFT;
+        out += (v < 0 ? 0 : v > 127 ? 127 : v) * m_output_weights[i];
+    }
+    return out / OUTPUT_SCALE;
+}
+
+bool NNUE::cpuHasSimd(int simd)
+{
+    if (simd == SCALAR)
+        return true;
+#ifdef NNUE_X86
+    if (simd == SSE2)
+        return __builtin_cpu_supports("sse2");
+    if (simd == AVX2)
+        return __builtin_cpu_supports("avx2");
+#endif
+    return false;
+}
@@ -0,0 +1,172 @@
+/***********************************************************************
+* NNUE.h Declaration of neural network evaluation for chess simulation *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#ifndef _NNUE_H_
+#define _NNUE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Move.h"
+
+// Forward declaration the ChessBoard class.
+class ChessBoard;
+
+/**
+ * Sums of the first layer of a network over the pieces on the board, one half from the view of each side.
+ */
+struct Accumulator
+{
+    // The half of White first, then the half of Black.
+    int16_t values[2][256];
+};
+
+/**
+ * An efficiently updatable neural network, evaluating a position from the pieces on the board.
+ * Each piece on each square is an input (768 in all), seen from both sides with the board flipped for Black.
+ * The first layer (768 -> 256 for each side) is kept in an accumulator, updated by adding or subtracting
+ * the weight column of a piece put on or taken off a square, so that only the small layers are run per evaluation:
+ * the two halves clipped to int8 (512) -> 32 by int8 weights, clipped again, -> 1.
+ * The layers are run by AVX2 or SSE2 where the CPU supports them, or else by plain code, all with the same result.
+ */
+class NNUE
+{
+public:
+    /**
+     * Constructor, with all weights zero and the best instruction set supported by the CPU.
+     */
+    NNUE();
+    /**
+     * Load the weights from a binary file, written by save on a host of any byte order.
+     * @param path: Path of the file.
+     * @return If the file is loaded, the weights are unchanged if not, as for a file of the wrong size.
+     */
+    bool load(const std::string& path);
+    /**
+     * Save the weights to a binary file.
+     * @param path: Path of the file.
+     * @return If the file is written.
+     */
+    bool save(const std::string& path);
+    /**
+     * Fill the weights with small random numbers from a fixed seed, for benchmarks and tests of the machinery.
+     * @param seed: The seed, not zero.
+     */
+    void randomize(uint64_t seed);
+    /**
+     * Set the instruction set the layers are run with.
+     * @param simd: One of SCALAR, SSE2 and AVX2.
+     * @return If the instruction set is supported by the CPU, the current one is kept if not.
+     */
+    bool setSimd(int simd);
+    /**
+     * Get the instruction set the layers are run with.
+     * @return One of SCALAR, SSE2 and AVX2.
+     */
+    inline int getSimd() const
+    {
+        return m_simd;
+    }
+    /**
+     * Compute an accumulator from scratch.
+     * @param acc: The accumulator.
+     * @param squares: Piece code of ChessBoard on each square, from A1 to H8.
+     */
+    void refresh(Accumulator& acc, const int8_t* squares) const;
+    /**
+     * Add a piece put on a square to an accumulator.
+     * @param acc: The accumulator.
+     * @param code: Piece code of ChessBoard.
+     * @param sq: The square.
+     */
+    void addPiece(Accumulator& acc, int code, int sq) const;
+    /**
+     * Subtract a piece taken off a square from an accumulator.
+     * @param acc: The accumulator.
+     * @param code: Piece code of ChessBoard.
+     * @param sq: The square.
+     */
+    void removePiece(Accumulator& acc, int code, int sq) const;
+    /**
+     * Move a piece on an accumulator, a subtraction and an addition in one pass.
+     * @param acc: The accumulator.
+     * @param code: Piece code of ChessBoard.
+     * @param src: The source square.
+     * @param dst: The destination square.
+     */
+    void movePiece(Accumulator& acc, int code, int src, int dst) const;
+    /**
+     * Work out the accumulator after a move from the one before it, so that taking the move back costs nothing.
+     * @param acc: The accumulator before the move.
+     * @param next: The accumulator after the move, not the same as acc.
+     * @param board: The board, still in the position before the move.
+     * @param move: The move.
+     */
+    void applyMove(const Accumulator& acc, Accumulator& next, ChessBoard& board, Move move) const;
+    /**
+     * Run the layers after the accumulator.
+     * @param acc: The accumulator of the position.
+     * @param side: The side to move.
+     * @return The score in centipawns, from the view of the side to move.
+     */
+    int evaluate(const Accumulator& acc, int side) const;
+    /**
+     * Check if the CPU supports an instruction set.
+     * @param simd: One of SCALAR, SSE2 and AVX2.
+     * @return The result.
+     */
+    static bool cpuHasSimd(int simd);
+
+public:
+    // Instruction sets.
+    static const int SCALAR = 0, SSE2 = 1, AVX2 = 2;
+    // Names of the instruction sets.
+    static const char* SIMD_NAME[3];
+    // Sizes of the layers.
+    static const int INPUT = 768, HIDDEN = 256, DENSE = 32;
+    // Right shift of the dense layer sums before they are clipped.
+    static const int DENSE_SHIFT = 6;
+    // Divisor from the output to centipawns.
+    static const int OUTPUT_SCALE = 16;
+
+private:
+    /**
+     * Get the index of the input of a piece on a square, from the view of a side.
+     * @param view: The side the board is seen from.
+     * @param code: Piece code of ChessBoard.
+     * @param sq: The square.
+     * @return The index.
+     */
+    inline static int inputIndex(int view, int code, int sq)
+    {
+        // Own pieces come first, and Black sees the board upside down.
+        return ((((code >> 3) ^ view) * 6 + (code & 7) - 1) << 6) + (view ? sq ^ 56 : sq);
+    }
+
+private:
+    // Instruction set in use.
+    int m_simd;
+    // Weights of the first layer, a column of HIDDEN for each input, and its biases.
+    std::vector<int16_t> m_input_weights;
+    std::vector<int16_t> m_input_biases;
+    // Weights of the dense layer, a row of 2 * HIDDEN for each output, and its biases.
+    std::vector<int8_t> m_dense_weights;
+    std::vector<int32_t> m_dense_biases;
+    // Weights of the output and its bias.
+    std::vector<int8_t> m_output_weights;
+    int32_t m_output_bias;
+};
+
+#endif
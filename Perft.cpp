@@ -0,0 +1,587 @@
+/***********************************************************************
+* Perft.cpp Implementation of move generation benchmark and checker    *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#include "ChessBoard.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+const char* USAGE = ""
+    "Usage:\n"
+    "\n"
+    " - perft [OPTION ...]:              Run the test suite: node counts, exchange values and FEN.\n"
+    "\n"
+    " - perft <DEPTH> [fen <FEN>] [MOVE ...]:\n"
+    "                                    Count leaf nodes to DEPTH from the start position or the quoted FEN,\n"
+    "                                    after the optional moves, e.g. E2E4 E7E5.\n"
+    "\n"
+    " - perft divide <DEPTH> [fen <FEN>] [MOVE ...]:\n"
+    "                                    Same as above, with counts broken down per root move.\n"
+    "\n"
+    "Options, placed before everything else:\n"
+    "\n"
+    " - threads <N>:                     Count on N threads, 1 by default.\n"
+    "\n"
+    " - split <PLY>:                     Split the work into a task for each move of the first PLY plies, 1 or 2.\n"
+    "\n"
+    " - hash <MB>:                       Cache counts of positions in a table shared by the threads.\n";
+
+// Maximum depth recorded in the test suite.
+const int MAX_DEPTH = 4;
+
+/**
+ * A test position, reached from a FEN position by a sequence of moves.
+ */
+struct PerftPosition
+{
+    // Name of the position.
+    const char* name;
+    // FEN of the position, the start position if empty.
+    const char* fen;
+    // Space separated moves played from the FEN position.
+    const char* moves;
+    // Expected number of leaf nodes at depth 1 ~ MAX_DEPTH.
+    uint64_t nodes[MAX_DEPTH];
+};
+
+// The test suite, covering castling, en-passant and promotion, and the well-known positions of the chess programming wiki.
+const PerftPosition SUITE[] = {
+    {"Start position", "", "", {20, 400, 8902, 197281}},
+    {"Castling on both sides", "", "E2E4 E7E5 G1F3 B8C6 F1C4 G8F6", {33, 930, 30542, 914790}},
+    {"En-passant", "", "E2E4 A7A6 E4E5 D7D5", {31, 781, 24166, 630536}},
+    {"Promotion", "", "A2A4 B7B5 A4B5 A7A6 B5A6 C8B7 A6B7 B8C6", {33, 890, 28808, 775934}},
+    {"Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", "",
+        {48, 2039, 97862, 4085603}},
+    {"Position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", "", {14, 191, 2812, 43238}},
+    {"Position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", "",
+        {6, 264, 9467, 422333}},
+    {"Position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", "", {44, 1486, 62379, 2103487}},
+    {"Position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", "",
+        {46, 2079, 89890, 3894594}},
+};
+
+/**
+ * A capture or a move with a known static exchange evaluation.
+ */
+struct SeePosition
+{
+    // FEN of the position.
+    const char* fen;
+    // The move, in its readable form.
+    const char* move;
+    // Expected material gain in centipawns.
+    int value;
+};
+
+// Exchanges with x-rays, defended and undefended pieces, en-passant, promotion and a hanging piece.
+const SeePosition SEE_SUITE[] = {
+    {"1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "E1E5", 100},
+    {"1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "D3E5", -220},
+    {"4k3/8/4p3/3n4/8/8/3R4/3QK3 w - - 0 1", "D2D5", -80},
+    {"4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1", "E4D5", 0},
+    {"4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1", "D2D5", -800},
+    {"4k3/8/8/3r4/8/8/3Q4/3RK3 w - - 0 1", "D2D5", 500},
+    {"3rk3/3r4/8/3n4/8/8/3Q4/3RK3 w - - 0 1", "D2D5", -580},
+    {"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "E5D6", 100},
+    {"4k3/8/8/3q4/4K3/8/8/8 w - - 0 1", "E4D5", 900},
+    {"3rk3/2P5/8/8/8/8/8/4K3 w - - 0 1", "C7D8Q", 400},
+    {"4k3/8/8/2p5/8/8/8/3RK3 w - - 0 1", "D1D4", -500},
+};
+
+/**
+ * A FEN string, and what the board makes of it.
+ */
+struct FenPosition
+{
+    // The FEN string.
+    const char* fen;
+    // FEN of the board set up from it, nullptr if it must be rejected.
+    const char* result;
+};
+
+// Move counters in and out of their range, and the fields which are dropped or filled in.
+const FenPosition FEN_SUITE[] = {
+    {"4k3/8/8/8/8/8/8/4K3 w - -", "4k3/8/8/8/8/8/8/4K3 w - - 0 1"},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 40000 0", "4k3/8/8/8/8/8/8/4K3 w - - 40000 1"},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 65535 65535", "4k3/8/8/8/8/8/8/4K3 w - - 65535 65535"},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 65536 1", nullptr},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 0 65536", nullptr},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 000001 1", nullptr},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 99999999999999999999 1", nullptr},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 0 99999999999999999999", nullptr},
+    {"4k3/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "4k3/8/8/8/8/8/8/R3K2R w KQ - 0 1"},
+    {"4k3/8/8/3pP3/8/8/8/4K3 w - d6 3 7", "4k3/8/8/3pP3/8/8/8/4K3 w - d6 3 7"},
+    {"4k3/8/8/3p4/8/8/8/4K3 w - d6 0 1", "4k3/8/8/3p4/8/8/8/4K3 w - - 0 1"},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 1", "4k3/8/8/8/8/8/8/4K3 w - - 1 1"},
+    {"4k3/8/8/8/8/8/8/R3K2R w KQ - 40000 20000", "4k3/8/8/8/8/8/8/R3K2R w KQ - 40000 20000"},
+};
+
+// An output stream discarding everything, for the boards used in the search.
+ostream null_stream(nullptr);
+
+/**
+ * Find a legal move by its readable form.
+ * @param board: The board.
+ * @param str: The readable form (e.g. "E2E4", "A7A8Q").
+ * @param move: Where the move is stored.
+ * @return If the move is found.
+ */
+bool findMove(ChessBoard& board, const string& str, Move& move)
+{
+    for (const Move& m: board.getLegalMoves())
+        if (m.str() == str)
+        {
+            move = m;
+            return true;
+        }
+    return false;
+}
+
+/**
+ * Play a sequence of moves from a FEN position.
+ * @param board: The board, which is set up first.
+ * @param fen: The FEN, the start position if empty.
+ * @param moves: Space separated moves.
+ * @return If the FEN is valid and all moves are legal.
+ */
+bool setupBoard(ChessBoard& board, const string& fen, const string& moves)
+{
+    if (fen.empty())
+        board.resetBoard();
+    else if (!board.setFEN(fen))
+    {
+        cout << fen << " is not a valid FEN!" << endl;
+        return false;
+    }
+    size_t begin = 0;
+    while (begin < moves.length())
+    {
+        size_t end = moves.find(' ', begin);
+        if (end == string::npos)
+            end = moves.length();
+        Move move;
+        if (end > begin && !findMove(board, moves.substr(begin, end - begin), move))
+        {
+            cout << moves.substr(begin, end - begin) << " is not a legal move!" << endl;
+            return false;
+        }
+        if (end > begin)
+            board.submitMove(move);
+        begin = end + 1;
+    }
+    return true;
+}
+
+/**
+ * A table of node counts keyed by the Zobrist key and the depth, shared by all threads without locks.
+ * Each entry holds the key XORed with the data, so that an entry torn by concurrent writers is never trusted.
+ */
+class PerftHash
+{
+public:
+    /**
+     * Constructor.
+     * @param mb: Memory budget in megabytes, rounded down to a power of two entries.
+     */
+    explicit PerftHash(size_t mb)
+    {
+        size_t size = 1;
+        while (size * 2 * sizeof(Entry) <= (mb << 20))
+            size *= 2;
+        m_entries.reset(new Entry[size]());
+        m_mask = size - 1;
+    }
+    /**
+     * Look up the count of a position.
+     * @param key: The Zobrist key.
+     * @param depth: Remaining depth, at least 2.
+     * @param nodes: Where the count is stored if found.
+     * @return If the count is found.
+     */
+    inline bool probe(uint64_t key, int depth, uint64_t& nodes)
+    {
+        Entry& entry = m_entries[index(key, depth)];
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ data) != key || (int) (data & 0xff) != depth)
+            return false;
+        nodes = data >> 8;
+        return true;
+    }
+    /**
+     * Store the count of a position, replacing whatever is there.
+     * @param key: The Zobrist key.
+     * @param depth: Remaining depth, at least 2.
+     * @param nodes: The count.
+     */
+    inline void store(uint64_t key, int depth, uint64_t nodes)
+    {
+        Entry& entry = m_entries[index(key, depth)];
+        uint64_t data = (nodes << 8) | (uint64_t) depth;
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * A packed entry, with the depth in bits 0 ~ 7 of the data and the count above.
+     */
+    struct Entry
+    {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+    /**
+     * Get the entry index of a position, different depths of the same position go to different entries.
+     */
+    inline size_t index(uint64_t key, int depth)
+    {
+        return (key ^ (depth * 0x9e3779b97f4a7c15ULL)) & m_mask;
+    }
+
+private:
+    std::unique_ptr<Entry[]> m_entries;
+    size_t m_mask;
+};
+
+/**
+ * Options of counting.
+ */
+struct PerftOptions
+{
+    // Number of threads.
+    int threads;
+    // Number of plies split into tasks.
+    int split;
+    // The shared table, can be nullptr.
+    PerftHash* hash;
+};
+
+/**
+ * A task of counting, the subtree after one or two moves from the root.
+ */
+struct PerftTask
+{
+    // Index of the root move.
+    int root;
+    // Moves played from the root.
+    Move moves[2];
+    int count;
+    // Result.
+    uint64_t nodes;
+};
+
+/**
+ * Count the leaf nodes of the move tree.
+ * @param board: The board.
+ * @param depth: Remaining depth.
+ * @param hash: The shared table, can be nullptr.
+ * @return Number of leaf nodes.
+ */
+uint64_t perft(ChessBoard& board, int depth, PerftHash* hash)
+{
+    if (depth == 0)
+        return 1;
+
+    MoveList list;
+    board.generateLegalMoves(list);
+
+    // Leaves are counted in bulk, without playing the moves.
+    if (depth == 1)
+        return list.size();
+
+    uint64_t nodes = 0;
+    if (hash && hash->probe(board.getHash(), depth, nodes))
+        return nodes;
+    for (const Move& move: list)
+    {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1, hash);
+        board.unmakeMove();
+    }
+    if (hash)
+        hash->store(board.getHash(), depth, nodes);
+    return nodes;
+}
+
+/**
+ * Take the tasks in turn and count them on a board of its own, run by each thread of the pool.
+ * @param position: The position at the root, which the board of the thread is set up from.
+ * @param depth: Remaining depth at the root.
+ * @param hash: The shared table, can be nullptr.
+ * @param tasks: The tasks.
+ * @param next: Index of the next task to take.
+ */
+void perftWorker(const Position& position, int depth, PerftHash* hash, vector<PerftTask>* tasks, atomic<size_t>* next)
+{
+    ChessBoard copy(position, null_stream);
+    for (size_t i = (*next)++; i < tasks->size(); i = (*next)++)
+    {
+        PerftTask& task = (*tasks)[i];
+        for (int m = 0; m < task.count; m++)
+            copy.makeMove(task.moves[m]);
+        task.nodes = perft(copy, depth - task.count, hash);
+        for (int m = 0; m < task.count; m++)
+            copy.unmakeMove();
+    }
+}
+
+/**
+ * Count the leaf nodes on a pool of threads, each with its own copy of the board.
+ * The tree is split into a task for each move of the first plies, and the tasks are taken by the threads in turn.
+ * @param board: The board.
+ * @param depth: Remaining depth, at least 1.
+ * @param options: Options of counting.
+ * @param moves: Where the root moves are stored.
+ * @param counts: Where the count of each root move is stored, in the same order as the moves.
+ * @return Number of leaf nodes.
+ */
+uint64_t parallelPerft(ChessBoard& board, int depth, const PerftOptions& options, MoveList& moves, vector<uint64_t>& counts)
+{
+    // Generate the tasks in the order of moves.
+    vector<PerftTask> tasks;
+    board.generateLegalMoves(moves);
+    for (int i = 0; i < moves.size(); i++)
+    {
+        PerftTask task = {i, {moves[i], Move()}, 1, 0};
+        if (options.split < 2 || depth < 3)
+        {
+            tasks.push_back(task);
+            continue;
+        }
+        MoveList replies;
+        board.makeMove(moves[i]);
+        board.generateLegalMoves(replies);
+        board.unmakeMove();
+        task.count = 2;
+        for (const Move& reply: replies)
+        {
+            task.moves[1] = reply;
+            tasks.push_back(task);
+        }
+    }
+
+    // Run the tasks, each thread with a board of the position, as the history is not needed.
+    // The position is passed by reference, as the copy std::thread would keep is not aligned to 64 bytes before C++17.
+    atomic<size_t> next(0);
+    vector<thread> threads;
+    Position position = board.getPosition();
+    for (int t = 0; t < options.threads; t++)
+        threads.emplace_back(perftWorker, cref(position), depth, options.hash, &tasks, &next);
+    for (thread& t: threads)
+        t.join();
+
+    // Merge the counts in the order of tasks, so the result does not depend on the scheduling.
+    uint64_t nodes = 0;
+    counts.assign(moves.size(), 0);
+    for (const PerftTask& task: tasks)
+    {
+        counts[task.root] += task.nodes;
+        nodes += task.nodes;
+    }
+    return nodes;
+}
+
+/**
+ * Count the leaf nodes.
+ * @param board: The board.
+ * @param depth: Remaining depth.
+ * @param options: Options of counting.
+ * @return Number of leaf nodes.
+ */
+uint64_t count(ChessBoard& board, int depth, const PerftOptions& options)
+{
+    if (depth <= 1)
+        return perft(board, depth, options.hash);
+    MoveList moves;
+    vector<uint64_t> counts;
+    return parallelPerft(board, depth, options, moves, counts);
+}
+
+/**
+ * Count the leaf nodes, and output the count of each root move.
+ * @param board: The board.
+ * @param depth: Remaining depth, at least 1.
+ * @param options: Options of counting.
+ * @return Number of leaf nodes.
+ */
+uint64_t divide(ChessBoard& board, int depth, const PerftOptions& options)
+{
+    MoveList moves;
+    vector<uint64_t> counts;
+    uint64_t nodes = parallelPerft(board, depth, options, moves, counts);
+    for (int i = 0; i < moves.size(); i++)
+        cout << moves[i].str() << ": " << counts[i] << '\n';
+    return nodes;
+}
+
+/**
+ * Output the node count with elapsed time and speed.
+ * @param nodes: Number of nodes.
+ * @param seconds: Elapsed time in seconds.
+ */
+void report(uint64_t nodes, double seconds)
+{
+    cout << nodes << " nodes, " << seconds << " s, ";
+    cout << (uint64_t) (seconds > 0 ? nodes / seconds : 0) << " nodes/s";
+}
+
+/*
+ * Perft driver, serving both as the move generation benchmark and as the regression check.
+ */
+int main(int argc, char* argv[])
+{
+    typedef chrono::steady_clock clock;
+    ChessBoard board(null_stream);
+    board.setVerbose(false);
+
+    // Read the options.
+    int arg = 1, hash_size = 0;
+    PerftOptions options = {1, 1, nullptr};
+    for (; arg + 1 < argc; arg += 2)
+    {
+        string option = argv[arg];
+        if (option == "threads")
+            options.threads = atoi(argv[arg + 1]);
+        else if (option == "split")
+            options.split = atoi(argv[arg + 1]);
+        else if (option == "hash")
+            hash_size = atoi(argv[arg + 1]);
+        else
+            break;
+    }
+    if (options.threads < 1 || options.split < 1 || options.split > 2 || hash_size < 0)
+    {
+        cout << USAGE;
+        return 1;
+    }
+    unique_ptr<PerftHash> hash(hash_size ? new PerftHash(hash_size) : nullptr);
+    options.hash = hash.get();
+
+    // Run the test suite.
+    if (arg == argc)
+    {
+        bool ok = true;
+        uint64_t total = 0;
+        double total_seconds = 0;
+        for (const PerftPosition& pos: SUITE)
+        {
+            cout << pos.name << endl;
+            if (!setupBoard(board, pos.fen, pos.moves))
+                return 1;
+            for (int depth = 1; depth <= MAX_DEPTH; depth++)
+            {
+                clock::time_point start = clock::now();
+                uint64_t nodes = count(board, depth, options);
+                double seconds = chrono::duration<double>(clock::now() - start).count();
+                total += nodes;
+                total_seconds += seconds;
+
+                cout << "  Depth " << depth << ": ";
+                report(nodes, seconds);
+                if (nodes == pos.nodes[depth - 1])
+                    cout << ", OK" << endl;
+                else
+                {
+                    cout << ", FAILED, expected " << pos.nodes[depth - 1] << endl;
+                    ok = false;
+                }
+            }
+        }
+        cout << "Static exchange evaluation" << endl;
+        for (const SeePosition& pos: SEE_SUITE)
+        {
+            Move move;
+            if (!setupBoard(board, pos.fen, "") || !findMove(board, pos.move, move))
+                return 1;
+            int value = board.see(move);
+            cout << "  " << pos.move << ": " << value;
+            if (value == pos.value)
+                cout << ", OK" << endl;
+            else
+            {
+                cout << ", FAILED, expected " << pos.value << endl;
+                ok = false;
+            }
+        }
+        cout << "FEN" << endl;
+        for (const FenPosition& pos: FEN_SUITE)
+        {
+            // Every move is made and taken back as well, which must restore all fields.
+            string result = board.setFEN(pos.fen) ? board.getFEN() : "rejected";
+            MoveList moves;
+            if (result != "rejected")
+                board.generateLegalMoves(moves);
+            for (Move move: moves)
+            {
+                board.makeMove(move);
+                board.unmakeMove();
+                if (board.getFEN() != result)
+                    result = board.getFEN() + " after " + move.str();
+            }
+            cout << "  " << pos.fen << ": " << result;
+            if (result == (pos.result ? pos.result : "rejected"))
+                cout << ", OK" << endl;
+            else
+            {
+                cout << ", FAILED, expected " << (pos.result ? pos.result : "rejected") << endl;
+                ok = false;
+            }
+        }
+        cout << endl << "Total: ";
+        report(total, total_seconds);
+        cout << endl << (ok ? "All passed" : "Some FAILED") << endl;
+        return ok ? 0 : 1;
+    }
+
+    // Count from a designated position.
+    bool split = string(argv[arg]) == "divide";
+    if (split)
+        arg++;
+    int depth = arg < argc ? atoi(argv[arg++]) : 0;
+    if (depth <= 0)
+    {
+        cout << USAGE;
+        return 1;
+    }
+    string fen, moves;
+    if (arg + 1 < argc && string(argv[arg]) == "fen")
+    {
+        fen = argv[arg + 1];
+        arg += 2;
+    }
+    for (; arg < argc; arg++)
+        moves += string(argv[arg]) + " ";
+    if (!setupBoard(board, fen, moves))
+        return 1;
+
+    clock::time_point start = clock::now();
+    uint64_t nodes = split ? divide(board, depth, options) : count(board, depth, options);
+    double seconds = chrono::duration<double>(clock::now() - start).count();
+    if (split)
+        cout << endl;
+    report(nodes, seconds);
+    cout << endl;
+    return 0;
+}
@@ -15,39 +15,26 @@
 #ifndef _PIECE_H_
 #define _PIECE_H_
 
-#include <string>
+#include "Bitboard.h"
 
-// Using pair<int, int> to represent a coordinate.
-typedef std::pair<int, int> coord;
-
-// Forward declaration the ChessBoard class.
-class ChessBoard;
 
 /**
- * The abstract class representing a general chess piece.
+ * The class representing a general chess piece, holding its side, type and position.
+ * The moves are generated and checked by the board core of ChessBoard, not by the pieces.
  */
 class Piece
 {
 public:
     /**
      * Constructor.
-     * @param board: A pointer pointing to the board.
      * @param side: Which side the piece belongs to.
      * @param pos: Initial position.
+     * @param type: Type of the piece, one of PAWN, ROOK, KNIGHT, BISHOP, QUEEN and KING.
      */
-    Piece(ChessBoard* board, int side, coord pos):
-        m_board(board), m_side(side), m_pos(pos), m_moved(false)
+    Piece(int side, coord pos, int type):
+        m_side(side), m_type(type), m_pos(pos), m_moved(false)
     {
     }
-    /**
-     * Deconstructor.
-     */
-    virtual ~Piece() = default;
-    /**
-     * Get the name of the piece, including side and type.
-     * @return The name.
-     */
-    virtual std::string getName();
     /**
      * Get the side of the piece.
      * @return The side.
@@ -56,6 +43,14 @@ public:
     {
         return m_side;
     }
+    /**
+     * Get the type of the piece.
+     * @return The type.
+     */
+    inline int getType()
+    {
+        return m_type;
+    }
     /**
      * Get current position of the piece.
      * @return The current position.
@@ -88,37 +83,35 @@ public:
     {
         m_moved = moved;
     }
-    /**
-     * Check whether there is any other piece on the direct path to the destination(excluded).
-     * @param pos Destination.
-     * @return The result.
-     */
-    bool pathCheck(coord pos);
-    /**
-     * Check whether the piece can move to the designated position.
-     * Note: This check does not consider the situation of the king after the movement.
-     * @param pos: The position.
-     * @return nullptr if this is invalid movement,
-     * or a pointer to another piece, if any piece is going to be taken,
-     * or a pointer to the piece itself, if none piece is going to be take.
-     */
-    virtual Piece* pieceCheck(coord pos);
     /**
      * Check if the piece is a pawn.
      * @return The result
      */
-    virtual bool isPawn();
+    inline bool isPawn()
+    {
+        return m_type == PAWN;
+    }
     /**
      * Get the one-char symbol of the piece.
      * @return The symbol.
      */
-    virtual char getSymbol() = 0;
+    inline char getSymbol()
+    {
+        return (m_side ? "prnbqk" : "PRNBQK")[m_type];
+    }
+
+public:
+    // Number of types of pieces, and their symbols.
+    static const int TYPE_NUM = 6;
+    static const int PAWN = 0, ROOK = 1, KNIGHT = 2, BISHOP = 3, QUEEN = 4, KING = 5;
+    // Names of each type.
+    static const char* TYPE_NAME[TYPE_NUM];
 
 protected:
-    // The chess board the piece is on.
-    ChessBoard* m_board;
     // Which side the piece belongs to.
     int m_side;
+    // The type of the piece.
+    int m_type;
     // The current position.
     coord m_pos;
     // If the piece has been moved.
@@ -126,109 +119,81 @@ protected:
 };
 
 /**
- * Derived class representing a King.
+ * Derived class representing a King, only a shorthand for constructing the piece.
  * For detailed information, please see the super class Piece.
  */
 class King: public Piece
 {
 public:
-    King(ChessBoard* board, int side, coord pos):
-        Piece(board, side, pos)
+    King(int side, coord pos):
+        Piece(side, pos, KING)
     {
     }
-    ~King() override = default;
-    std::string getName() override;
-    Piece* pieceCheck(coord pos) override;
-    char getSymbol() override;
 };
 
 /**
- * Derived class representing a King.
+ * Derived class representing a Rook, only a shorthand for constructing the piece.
  * For detailed information, please see the super class Piece.
  */
 class Rook: public Piece
 {
 public:
-    Rook(ChessBoard* board, int side, coord pos):
-        Piece(board, side, pos)
+    Rook(int side, coord pos):
+        Piece(side, pos, ROOK)
     {
     }
-    ~Rook() override = default;
-    std::string getName() override;
-    Piece* pieceCheck(coord pos) override;
-    char getSymbol() override;
 };
 
 /**
- * Derived class representing a King.
+ * Derived class representing a Bishop, only a shorthand for constructing the piece.
  * For detailed information, please see the super class Piece.
  */
 class Bishop: public Piece
 {
 public:
-    Bishop(ChessBoard* board, int side, coord pos):
-        Piece(board, side, pos)
+    Bishop(int side, coord pos):
+        Piece(side, pos, BISHOP)
     {
     }
-    ~Bishop() override = default;
-    std::string getName() override;
-    Piece* pieceCheck(coord pos) override;
-    char getSymbol() override;
 };
 
 /**
- * Derived class representing a King.
+ * Derived class representing a Queen, only a shorthand for constructing the piece.
  * For detailed information, please see the super class Piece.
  */
 class Queen: public Piece
 {
 public:
-    Queen(ChessBoard* board, int side, coord pos):
-        Piece(board, side, pos)
+    Queen(int side, coord pos):
+        Piece(side, pos, QUEEN)
     {
     }
-    ~Queen() override = default;
-    std::string getName() override;
-    Piece* pieceCheck(coord pos) override;
-    char getSymbol() override;
 };
 
 /**
- * Derived class representing a King.
+ * Derived class representing a Knight, only a shorthand for constructing the piece.
  * For detailed information, please see the super class Piece.
  */
 class Knight: public Piece
 {
 public:
-    Knight(ChessBoard* board, int side, coord pos):
-        Piece(board, side, pos)
+    Knight(int side, coord pos):
+        Piece(side, pos, KNIGHT)
     {
     }
-    ~Knight() override = default;
-    std::string getName() override;
-    Piece* pieceCheck(coord pos) override;
-    char getSymbol() override;
 };
 
 /**
- * Derived class representing a King.
+ * Derived class representing a Pawn, only a shorthand for constructing the piece.
  * For detailed information, please see the super class Piece.
  */
 class Pawn: public Piece
 {
 public:
-    Pawn(ChessBoard* board, int side, coord pos):
-        Piece(board, side, pos), m_direct(side ? -1 : 1)
+    Pawn(int side, coord pos):
+        Piece(side, pos, PAWN)
     {
     }
-    ~Pawn() override = default;
-    std::string getName() override;
-    bool isPawn() override;
-    Piece* pieceCheck(coord pos) override;
-    char getSymbol() override;
-private:
-    // The direct (up or down) which the pawn can move.
-    int m_direct;
 };
 
 #endif
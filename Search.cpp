@@ -0,0 +1,305 @@
+/***********************************************************************
+* Search.cpp Implementation of alpha-beta search engine for chess game *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#include "Search.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+
+Search::Search(ChessBoard& board, TransTable* table, ostream& ostr):
+    m_board(board), m_table(table), m_threads(1), m_network(nullptr), m_nodes(0), m_published(0), m_score(0), m_timed(false),
+    m_stopped(false), m_stop_flag(false), m_stop(&m_stop_flag), m_ostr(ostr)
+{
+}
+
+Move Search::think(int depth, int movetime)
+{
+    // Reset the time limit.
+    m_stop_flag = false;
+    m_timed = movetime > 0;
+    clock::time_point start = clock::now();
+    m_deadline = start + chrono::milliseconds(movetime);
+    if (depth <= 0 || depth > MAX_DEPTH)
+        depth = MAX_DEPTH;
+    if (m_table)
+        m_table->newSearch();
+
+    // Nothing to search or report in checkmate or stalemate.
+    if (m_board.getLegalMoves().size() == 0)
+    {
+        int side = m_board.getSide();
+        m_nodes = 0;
+        m_thread_nodes.assign(1, 0);
+        m_score = m_board.isSquareAttacked(lsb(m_board.getPieces(side, Piece::KING)), 1 - side) ? -MATE : 0;
+        m_best = Move();
+        return m_best;
+    }
+
+    // Start the helper threads, each on its own copy of the board, stopped by the main thread.
+    vector<unique_ptr<ChessBoard>> boards;
+    vector<unique_ptr<Search>> helpers;
+    vector<thread> threads;
+    for (int i = 1; i < m_threads; i++)
+    {
+        boards.emplace_back(new ChessBoard(m_board));
+        helpers.emplace_back(new Search(*boards.back(), m_table, m_ostr));
+        helpers.back()->m_stop = &m_stop_flag;
+        helpers.back()->m_network = m_network;
+        m_helpers.push_back(helpers.back().get());
+        threads.emplace_back(&Search::iterate, helpers.back().get(), depth, i, start);
+    }
+
+    // Search on the main thread, and stop the helpers when it is done.
+    iterate(depth, 0, start);
+    m_stop_flag = true;
+    for (thread& t: threads)
+        t.join();
+    m_helpers.clear();
+    m_thread_nodes.assign(1, m_nodes);
+    for (unique_ptr<Search>& helper: helpers)
+        m_thread_nodes.push_back(helper->m_nodes);
+
+    // If the first iteration is not even finished, take whatever has been found.
+    if (m_best.isNull())
+    {
+        MoveList list;
+        m_board.generateLegalMoves(list);
+        if (list.size())
+            m_best = m_root.isNull() ? list[0] : m_root;
+    }
+    m_ostr.flush();
+    return m_best;
+}
+
+/*
+ * Helpers with an odd index start one ply deeper than the main thread,
+ * so that the threads do not all search the same depth at the same time.
+ */
+void Search::iterate(int depth, int id, clock::time_point start)
+{
+    m_nodes = 0;
+    m_published = 0;
+    m_score = 0;
+    m_best = Move();
+    m_stopped = false;
+    memset(m_killers, 0, sizeof(m_killers));
+    memset(m_history, 0, sizeof(m_history));
+    if (m_network)
+    {
+        m_accumulators.resize(MAX_DEPTH + 1);
+        m_network->refresh(m_accumulators[0], m_board.getPosition().squares);
+    }
+
+    // Search one ply deeper in each iteration, starting from the best move of the last one.
+    for (int d = 1 + (id & 1); d <= depth; d++)
+    {
+        m_root = Move();
+        int score = negamax(d, 0, -INFINITE, INFINITE);
+        if (m_stopped)
+            break;
+        m_best = m_root;
+        m_score = score;
+
+        // Report the iteration, with the nodes of all threads.
+        if (id == 0)
+        {
+            uint64_t nodes = m_nodes;
+            for (Search* helper: m_helpers)
+                nodes += helper->m_published.load(memory_order_relaxed);
+            double seconds = chrono::duration<double>(clock::now() - start).count();
+            m_ostr << "info depth " << d << " score ";
+            if (abs(score) >= MATE - MAX_DEPTH)
+                m_ostr << "mate " << (score > 0 ? (MATE - score + 1) / 2 : -(MATE + score) / 2);
+            else
+                m_ostr << "cp " << score;
+            m_ostr << " nodes " << nodes << " nps " << (uint64_t) (seconds > 0 ? nodes / seconds : 0);
+            m_ostr << " time " << (int) (seconds * 1000) << " pv " << m_best.str() << '\n';
+        }
+
+        // Nothing to search further if a mate is found.
+        if (abs(score) >= MATE - MAX_DEPTH)
+            break;
+    }
+}
+
+/*
+ * Scores are from the view of the side to move, and a mate found nearer to the root scores higher.
+ * The search is aborted when the time is up, and an aborted iteration is thrown away by think.
+ */
+int Search::negamax(int depth, int ply, int alpha, int beta)
+{
+    if ((++m_nodes & (CHECK_INTERVAL - 1)) == 0 && checkTime())
+        m_stopped = true;
+    if (m_stopped)
+        return 0;
+
+    // Draws by the fifty-move rule, repetition or insufficient material. A single repetition is enough inside the tree.
+    if (ply > 0 && (m_board.getHalfmoveClock() >= ChessBoard::FIFTY_MOVE || m_board.isRepetition(2) ||
+        m_board.isInsufficientMaterial()))
+        return 0;
+
+    if (depth == 0)
+        return quiesce(ply, alpha, beta);
+
+    // Take the result of the transposition table if it is deep enough and its bound fits the window.
+    TransEntry entry;
+    Move hash_move;
+    if (m_table && m_table->probe(m_board.getHash(), entry))
+    {
+        hash_move = entry.move;
+        int score = scoreFromTable(entry.score, ply);
+        if (ply > 0 && entry.depth >= depth && (entry.bound == TransTable::EXACT ||
+            (entry.bound == TransTable::LOWER && score >= beta) || (entry.bound == TransTable::UPPER && score <= alpha)))
+            return score;
+    }
+
+    // At the root, the best move of the last iteration goes first.
+    MovePicker picker(m_board, ply == 0 && !m_best.isNull() ? m_best : hash_move, m_killers[ply], &m_history);
+    int bound = TransTable::UPPER, played = 0;
+    Move best;
+    for (Move move = picker.next(); !move.isNull(); move = picker.next())
+    {
+        played++;
+        makeMove(move, ply);
+        int score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+        m_board.unmakeMove();
+        if (m_stopped)
+            return 0;
+
+        if (score > alpha)
+        {
+            alpha = score;
+            best = move;
+            bound = TransTable::EXACT;
+            if (ply == 0)
+                m_root = move;
+            if (alpha >= beta)
+            {
+                bound = TransTable::LOWER;
+                if (!move.isCapture() && !move.isPromotion())
+                    updateQuiet(move, depth, ply);
+                break;
+            }
+        }
+    }
+
+    // Checkmate or stalemate.
+    if (played == 0)
+    {
+        int side = m_board.getSide();
+        return m_board.isSquareAttacked(lsb(m_board.getPieces(side, Piece::KING)), 1 - side) ? -MATE + ply : 0;
+    }
+
+    if (m_table)
+        m_table->store(m_board.getHash(), best, scoreToTable(alpha, ply), depth, bound);
+    return alpha;
+}
+
+/*
+ * The side to move may stand pat on the static score, as it is not forced to take, unless it is in check,
+ * where all moves are searched so that a mate at the leaves is still seen.
+ * Evasions can go on for a while, so draws are checked as in the main search, and the static score is taken
+ * at MAX_DEPTH plies from the root, which also keeps mate scores inside the range the table conversion expects.
+ */
+int Search::quiesce(int ply, int alpha, int beta)
+{
+    if ((++m_nodes & (CHECK_INTERVAL - 1)) == 0 && checkTime())
+        m_stopped = true;
+    if (m_stopped)
+        return 0;
+
+    if (m_board.getHalfmoveClock() >= ChessBoard::FIFTY_MOVE || m_board.isRepetition(2) ||
+        m_board.isInsufficientMaterial())
+        return 0;
+    if (ply >= MAX_DEPTH)
+        return evaluate(ply);
+
+    int side = m_board.getSide();
+    bool check = m_board.isSquareAttacked(lsb(m_board.getPieces(side, Piece::KING)), 1 - side);
+    if (!check)
+    {
+        int score = evaluate(ply);
+        if (score >= beta)
+            return beta;
+        if (score > alpha)
+            alpha = score;
+    }
+
+    MovePicker picker(m_board, Move(), nullptr, nullptr, !check);
+    int played = 0;
+    for (Move move = picker.next(); !move.isNull(); move = picker.next())
+    {
+        played++;
+        makeMove(move, ply);
+        int score = -quiesce(ply + 1, -beta, -alpha);
+        m_board.unmakeMove();
+        if (m_stopped)
+            return 0;
+
+        if (score > alpha)
+        {
+            alpha = score;
+            if (alpha >= beta)
+                break;
+        }
+    }
+    if (check && played == 0)
+        return -MATE + ply;
+    return alpha;
+}
+
+void Search::updateQuiet(Move move, int depth, int ply)
+{
+    // Keep the two latest killers of the ply, without repeating one.
+    if (m_killers[ply][0] != move)
+    {
+        m_killers[ply][1] = m_killers[ply][0];
+        m_killers[ply][0] = move;
+    }
+
+    // Deeper cutoffs count more, and all scores are halved once one gets too high, so that old ones fade.
+    int& score = m_history[m_board.getSide()][move.getSrc()][move.getDst()];
+    score += depth * depth;
+    if (score >= HISTORY_LIMIT)
+        for (int side = 0; side < ChessBoard::SIDE; side++)
+            for (int src = 0; src < ChessBoard::ROW * ChessBoard::COL; src++)
+                for (int dst = 0; dst < ChessBoard::ROW * ChessBoard::COL; dst++)
+                    m_history[side][src][dst] /= 2;
+}
+
+bool Search::checkTime()
+{
+    m_published.store(m_nodes, memory_order_relaxed);
+    if (m_stop->load(memory_order_relaxed))
+        return true;
+    if (m_timed && clock::now() >= m_deadline)
+    {
+        m_stop->store(true, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+int Search::evaluate(int ply)
+{
+    if (m_network)
+        return m_network->evaluate(m_accumulators[ply], m_board.getSide());
+    int score = m_board.getMaterialScore();
+    return m_board.getSide() == ChessBoard::WHITE ? score : -score;
+}
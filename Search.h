@@ -0,0 +1,231 @@
+/***********************************************************************
+* Search.h Declaration of alpha-beta search engine for chess game      *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "ChessBoard.h"
+#include "Move.h"
+#include "MovePicker.h"
+#include "NNUE.h"
+#include "TransTable.h"
+
+
+/**
+ * A negamax alpha-beta search over the board core of a chess board.
+ * The search only uses the move picker, makeMove and unmakeMove, so there is no output and no allocation inside.
+ * With more than one thread, helper threads search the same position on their own copies of the board (Lazy SMP),
+ * and only share the transposition table, which fills it with results the main thread picks up.
+ */
+class Search
+{
+    typedef std::chrono::steady_clock clock;
+
+public:
+    /**
+     * Constructor.
+     * @param board: The board to search on, which is restored after each search.
+     * @param table: The transposition table shared by the searches, can be nullptr.
+     * @param ostr: An ostream object where the progress of each iteration flows to.
+     */
+    explicit Search(ChessBoard& board, TransTable* table=nullptr, std::ostream& ostr=std::cout);
+    /**
+     * Search the current position by iterative deepening, until the depth is reached or the time is up.
+     * @param depth: Maximum depth in plies, 0 for MAX_DEPTH.
+     * @param movetime: Time limit in milliseconds, 0 for no limit.
+     * @return The best move, a null move if there is no legal move.
+     */
+    Move think(int depth, int movetime=0);
+    /**
+     * Set the number of threads used by the following searches.
+     * @param threads: Number of threads, at least 1.
+     */
+    inline void setThreads(int threads)
+    {
+        m_threads = threads < 1 ? 1 : threads;
+    }
+    /**
+     * Set the network the following searches evaluate with.
+     * @param network: The network, which must outlive the searches, or nullptr for material and piece-square tables.
+     */
+    inline void setNetwork(const NNUE* network)
+    {
+        m_network = network;
+    }
+    /**
+     * Get the number of nodes visited by the last search, by all threads.
+     * @return Number of nodes.
+     */
+    inline uint64_t getNodes()
+    {
+        uint64_t nodes = 0;
+        for (uint64_t n: m_thread_nodes)
+            nodes += n;
+        return nodes;
+    }
+    /**
+     * Get the number of nodes visited by each thread in the last search, the main thread first.
+     * @return Numbers of nodes.
+     */
+    inline const std::vector<uint64_t>& getThreadNodes()
+    {
+        return m_thread_nodes;
+    }
+    /**
+     * Get the score of the best move of the last search.
+     * @return The score in centipawns, from the view of the side to move.
+     */
+    inline int getScore()
+    {
+        return m_score;
+    }
+
+private:
+    /**
+     * Deepen the search iteration by iteration, until the depth is reached or the search is stopped.
+     * @param depth: Maximum depth.
+     * @param id: Index of the thread, only the main thread (0) reports the iterations.
+     * @param start: Start time of the search.
+     */
+    void iterate(int depth, int id, clock::time_point start);
+    /**
+     * Search a position to a depth.
+     * @param depth: Remaining depth.
+     * @param ply: Distance from the root.
+     * @param alpha: Lower bound of the window.
+     * @param beta: Upper bound of the window.
+     * @return The score from the view of the side to move.
+     */
+    int negamax(int depth, int ply, int alpha, int beta);
+    /**
+     * Search only the captures and promotions of a position, until it is quiet, so that leaves are not scored
+     * in the middle of an exchange. Captures losing material by the static exchange evaluation are skipped.
+     * Positions MAX_DEPTH plies from the root are scored statically.
+     * @param ply: Distance from the root.
+     * @param alpha: Lower bound of the window.
+     * @param beta: Upper bound of the window.
+     * @return The score from the view of the side to move.
+     */
+    int quiesce(int ply, int alpha, int beta);
+    /**
+     * Remember a quiet move causing a cutoff, as a killer of its ply and in the history scores.
+     * @param move: The move.
+     * @param depth: Remaining depth of the position.
+     * @param ply: Distance from the root.
+     */
+    void updateQuiet(Move move, int depth, int ply);
+    /**
+     * Carry out a move on the board, and work out the accumulator of the next ply if there is a network.
+     * @param move: The move.
+     * @param ply: Distance of the position before the move from the root.
+     */
+    inline void makeMove(Move move, int ply)
+    {
+        if (m_network)
+            m_network->applyMove(m_accumulators[ply], m_accumulators[ply + 1], m_board, move);
+        m_board.makeMove(move);
+    }
+    /**
+     * Evaluate the current position statically by the network,
+     * or else by material and piece-square tables, as kept up to date by the board.
+     * @param ply: Distance from the root.
+     * @return The score in centipawns, from the view of the side to move.
+     */
+    int evaluate(int ply);
+    /**
+     * Convert a score into the form stored in the transposition table, where mate scores count from the position.
+     * @param score: The score, with mate scores counted from the root.
+     * @param ply: Distance from the root.
+     * @return The converted score.
+     */
+    inline static int scoreToTable(int score, int ply)
+    {
+        return score >= MATE - MAX_DEPTH ? score + ply : score <= -MATE + MAX_DEPTH ? score - ply : score;
+    }
+    /**
+     * Convert a score from the transposition table back, where mate scores count from the root.
+     * @param score: The score stored.
+     * @param ply: Distance from the root.
+     * @return The converted score.
+     */
+    inline static int scoreFromTable(int score, int ply)
+    {
+        return score >= MATE - MAX_DEPTH ? score - ply : score <= -MATE + MAX_DEPTH ? score + ply : score;
+    }
+    /**
+     * Check if the search is stopped or the time is up, which is only done once in a while.
+     * The node count is published for the report of the main thread at the same time.
+     * @return The result.
+     */
+    bool checkTime();
+
+public:
+    // Score bounds, and the score of being mated at the root.
+    static const int INFINITE = 32000, MATE = 31000;
+    // Maximum depth of iterative deepening.
+    static const int MAX_DEPTH = 64;
+
+private:
+    // Number of nodes between two time checks.
+    static const int CHECK_INTERVAL = 2048;
+    // History score at which all scores are halved.
+    static const int HISTORY_LIMIT = 1 << 20;
+
+private:
+    // The board.
+    ChessBoard& m_board;
+    // The transposition table, can be nullptr.
+    TransTable* m_table;
+    // Number of threads.
+    int m_threads;
+    // The network, nullptr if none.
+    const NNUE* m_network;
+    // Accumulators of the network along the current line, by ply, only kept while there is a network.
+    std::vector<Accumulator> m_accumulators;
+    // Number of nodes visited by this thread, and its copy visible to the main thread.
+    uint64_t m_nodes;
+    std::atomic<uint64_t> m_published;
+    // Numbers of nodes visited by each thread in the last search.
+    std::vector<uint64_t> m_thread_nodes;
+    // Helper searches of the main thread, during a search.
+    std::vector<Search*> m_helpers;
+    // Score of the best move.
+    int m_score;
+    // Best move of the last finished iteration.
+    Move m_best;
+    // Killer moves of each ply.
+    Move m_killers[MAX_DEPTH][MovePicker::KILLER_NUM];
+    // History scores of quiet moves.
+    HistoryTable m_history;
+    // Best move at the root of the current iteration.
+    Move m_root;
+    // Deadline of the search, only used when it is timed.
+    clock::time_point m_deadline;
+    bool m_timed;
+    // If the search has been stopped by the time limit or by the main thread.
+    bool m_stopped;
+    // Stop flag shared by all threads, owned by the main thread.
+    std::atomic<bool> m_stop_flag;
+    std::atomic<bool>* m_stop;
+    // Reference of output stream.
+    std::ostream& m_ostr;
+};
+
+#endif
@@ -0,0 +1,148 @@
+/***********************************************************************
+* TransTable.cpp Implementation of transposition table for chess search*
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#include "TransTable.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+using namespace std;
+
+
+TransTable::TransTable(size_t mb, bool huge_pages):
+    m_table(nullptr), m_clusters(0), m_bytes(0), m_huge_pages(false), m_mapped(false), m_age(0)
+{
+    resize(mb, huge_pages);
+}
+
+TransTable::~TransTable()
+{
+    release();
+}
+
+/*
+ * Huge pages are first asked for explicitly by mmap, which needs pages reserved by the system,
+ * and then as transparent huge pages on memory aligned to the huge page size.
+ */
+void TransTable::resize(size_t mb, bool huge_pages)
+{
+    release();
+
+    // Round down to a power of two clusters, at least one.
+    m_clusters = 1;
+    while (m_clusters * 2 * sizeof(Cluster) <= (mb << 20))
+        m_clusters *= 2;
+    m_bytes = m_clusters * sizeof(Cluster);
+
+    void* memory = nullptr;
+    if (huge_pages)
+    {
+#ifdef MAP_HUGETLB
+        size_t bytes = (m_bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED)
+            memory = nullptr;
+        else
+        {
+            m_bytes = bytes;
+            m_mapped = m_huge_pages = true;
+        }
+#endif
+    }
+    if (!memory)
+    {
+        if (posix_memalign(&memory, huge_pages ? HUGE_PAGE : 64, m_bytes))
+            throw bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if (huge_pages)
+            m_huge_pages = madvise(memory, m_bytes, MADV_HUGEPAGE) == 0;
+#endif
+    }
+    m_table = static_cast<Cluster*>(memory);
+    clear();
+}
+
+void TransTable::clear()
+{
+    memset(static_cast<void*>(m_table), 0, m_clusters * sizeof(Cluster));
+    m_age = 0;
+}
+
+bool TransTable::probe(uint64_t key, TransEntry& entry)
+{
+    Entry* entries = m_table[key & (m_clusters - 1)].entries;
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t data = entries[i].data.load(memory_order_relaxed);
+        if ((entries[i].check.load(memory_order_relaxed) ^ data) != key || !data)
+            continue;
+
+        entry.move = Move((int) (data & 0x3f), (int) ((data >> 6) & 0x3f), (int) ((data >> 12) & 0xf));
+        entry.score = (int16_t) (data >> 16);
+        entry.depth = (int) ((data >> 32) & 0xff);
+        entry.bound = (int) ((data >> 40) & 3);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * An entry is worth its depth, minus a penalty for each search it has been left behind,
+ * so that deep results are kept for a while but do not fill the table forever.
+ */
+void TransTable::store(uint64_t key, Move move, int score, int depth, int bound)
+{
+    Entry* entries = m_table[key & (m_clusters - 1)].entries;
+    Entry* replace = entries;
+    int worst = 1 << 30;
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t data = entries[i].data.load(memory_order_relaxed);
+        if ((entries[i].check.load(memory_order_relaxed) ^ data) == key || !data)
+        {
+            // Keep the best move of the same position, if none is given.
+            if (move.isNull() && data)
+                move = Move((int) (data & 0x3f), (int) ((data >> 6) & 0x3f), (int) ((data >> 12) & 0xf));
+            replace = entries + i;
+            break;
+        }
+        int age = (m_age - (int) ((data >> 42) & AGE_MASK)) & AGE_MASK;
+        int value = (int) ((data >> 32) & 0xff) - 8 * age;
+        if (value < worst)
+        {
+            worst = value;
+            replace = entries + i;
+        }
+    }
+
+    uint64_t data = (uint64_t) move.getData() | ((uint64_t) (uint16_t) score << 16) |
+        ((uint64_t) (depth & 0xff) << 32) | ((uint64_t) bound << 40) | ((uint64_t) m_age << 42);
+    replace->check.store(key ^ data, memory_order_relaxed);
+    replace->data.store(data, memory_order_relaxed);
+}
+
+void TransTable::release()
+{
+    if (!m_table)
+        return;
+    if (m_mapped)
+        munmap(m_table, m_bytes);
+    else
+        free(m_table);
+    m_table = nullptr;
+    m_huge_pages = m_mapped = false;
+}
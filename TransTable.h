@@ -0,0 +1,161 @@
+/***********************************************************************
+* TransTable.h Declaration of transposition table for chess search     *
+*                                                                      *
+* This file is part of Terminal Chess.                                 *
+*                                                                      *
+* Copyright 2019-2020 SBofGaySchoolBuPaAnything                        *
+*                                                                      *
+* Terminal Chess is free software under LGPLv3.                        *
+*                                                                      *
+* You should have received a copy of the GNU Lesser General Public     *
+* License along with this program.  If not, see                        *
+* <http://www.gnu.org/licenses/>.                                      *
+***********************************************************************/
+
+#ifndef _TRANS_TABLE_H_
+#define _TRANS_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "Move.h"
+
+
+/**
+ * Unpacked content of a transposition table entry.
+ */
+struct TransEntry
+{
+    // Best move found, can be a null move.
+    Move move;
+    // Score, with mate scores relative to the position of the entry.
+    int score;
+    // Remaining depth searched.
+    int depth;
+    // Bound type of the score.
+    int bound;
+};
+
+/**
+ * A fixed-size hash table of searched positions, keyed by the Zobrist key.
+ * Each entry takes 16 bytes, a key word XORed with the data word and the data word itself,
+ * so that an entry torn by concurrent writers fails the verification instead of returning wrong data.
+ * Four entries make up a cluster on one cache line, and the shallowest or oldest one is replaced.
+ */
+class TransTable
+{
+public:
+    /**
+     * Constructor.
+     * @param mb: Memory budget in megabytes.
+     * @param huge_pages: Whether to back the table by huge pages, if the system allows.
+     */
+    explicit TransTable(size_t mb=DEFAULT_SIZE, bool huge_pages=false);
+    /**
+     * Deconstructor.
+     */
+    ~TransTable();
+    TransTable(const TransTable&) = delete;
+    TransTable& operator=(const TransTable&) = delete;
+    /**
+     * Reallocate the table with a new memory budget, and clear it.
+     * @param mb: Memory budget in megabytes, rounded down to a power of two clusters.
+     * @param huge_pages: Whether to back the table by huge pages, if the system allows.
+     */
+    void resize(size_t mb, bool huge_pages=false);
+    /**
+     * Remove all entries.
+     */
+    void clear();
+    /**
+     * Mark the start of a new search, so that entries of the previous searches get older.
+     */
+    inline void newSearch()
+    {
+        m_age = (m_age + 1) & AGE_MASK;
+    }
+    /**
+     * Look up a position.
+     * @param key: The Zobrist key.
+     * @param entry: Where the content is stored if found.
+     * @return If the position is found.
+     */
+    bool probe(uint64_t key, TransEntry& entry);
+    /**
+     * Store a position, replacing the entry of the same position, or else the least valuable one in the cluster.
+     * @param key: The Zobrist key.
+     * @param move: Best move, can be a null move.
+     * @param score: Score, with mate scores relative to the position.
+     * @param depth: Remaining depth searched, at least 1.
+     * @param bound: One of EXACT, LOWER and UPPER.
+     */
+    void store(uint64_t key, Move move, int score, int depth, int bound);
+    /**
+     * Get the size of the table.
+     * @return Size in bytes.
+     */
+    inline size_t getSize()
+    {
+        return m_clusters * sizeof(Cluster);
+    }
+    /**
+     * Check if the table is backed by huge pages.
+     * @return The result.
+     */
+    inline bool isHugePages()
+    {
+        return m_huge_pages;
+    }
+
+public:
+    // Bound types.
+    static const int EXACT = 0, LOWER = 1, UPPER = 2;
+    // Default memory budget in megabytes.
+    static const size_t DEFAULT_SIZE = 16;
+
+private:
+    /**
+     * A packed entry.
+     */
+    struct Entry
+    {
+        // The Zobrist key XORed with the data.
+        std::atomic<uint64_t> check;
+        // Move in bits 0 ~ 15, score in bits 16 ~ 31, depth in bits 32 ~ 39, bound in bits 40 ~ 41, age in bits 42 ~ 47.
+        std::atomic<uint64_t> data;
+    };
+    /**
+     * Entries sharing a cache line.
+     */
+    struct Cluster
+    {
+        Entry entries[4];
+    };
+    /**
+     * Release the memory of the table.
+     */
+    void release();
+
+private:
+    // Number of ages before they wrap around.
+    static const int AGE_MASK = 63;
+    // Size of a huge page.
+    static const size_t HUGE_PAGE = 2 << 20;
+
+private:
+    // The clusters.
+    Cluster* m_table;
+    // Number of clusters, a power of two.
+    size_t m_clusters;
+    // Bytes allocated.
+    size_t m_bytes;
+    // Whether the memory is backed by huge pages.
+    bool m_huge_pages;
+    // Whether the memory is from mmap, otherwise it is from posix_memalign.
+    bool m_mapped;
+    // Age of the current search.
+    int m_age;
+};
+
+#endif
@@ -155,7 +155,8 @@ const pair<const char*, int> View::STATUS[STATUS_NUM] =
     pair<const char*, int>("Normal", fc::Green),
     pair<const char*, int>("Check", fc::Yellow),
     pair<const char*, int>("Stalemate", fc::Red),
-    pair<const char*, int>("Checkmate", fc::Red)
+    pair<const char*, int>("Checkmate", fc::Red),
+    pair<const char*, int>("Draw", fc::Red)
 };
 
 View::View(FWidget* parent):
@@ -532,18 +533,11 @@ void View::onClose(FCloseEvent *ev)
 
 bool View::load(bool msg)
 {
-    char chr;
-
     // If there is any message beforehand.
     if (msg)
     {
-        // Move the pointer to the front of the steam
-        m_istr.seekg(0, ios::beg);
-
-        // Read everything and append them to the record displayer.
-        string ipt;
-        while (m_istr.get(chr))
-            ipt.push_back(chr);
+        // Append everything written by the board to the record displayer.
+        string ipt = m_istr.str();
         ipt.push_back('\n');
         m_record->appendStr(ipt);
 
@@ -551,61 +545,22 @@ bool View::load(bool msg)
         cleanStream();
     }
 
-    // Request the core to draw the board.
-    m_board->drawBoard(true);
-
-    // Rewind the pointer before reading.
-    m_istr.seekg(0, ios::beg);
-
-    // Read and display all information.
-    int player, state, promoting;
-    m_istr >> player >> state >> promoting;
+    // Read and display all information from the board.
+    int player = m_board->getSide(), state = m_board->getStatus();
     m_status_player->setText(player ? "Black" : "White");
     m_status_state->setText(STATUS[state].first);
     m_status_state->setForegroundColor((FColor) STATUS[state].second);
 
-    // Read and display all pieces.
+    // Display all pieces, whose types are in the same order as those of the board, with the 8th row on the top.
     for (int r = 0; r < ChessBoard::ROW; r++)
     {
         for (int c = 0; c < ChessBoard::COL; c++)
         {
-            m_istr >> chr;
-            int side = islower(chr) ? ChessBoard::BLACK : ChessBoard::WHITE;
-            switch(toupper(chr))
-            {
-                case 'P':
-                {
-                    m_pieces[r][c]->setText(PIECE[m_style][PAWN][side]);
-                    break;
-                }
-                case 'R':
-                {
-                    m_pieces[r][c]->setText(PIECE[m_style][ROOK][side]);
-                    break;
-                }
-                case 'N':
-                {
-                    m_pieces[r][c]->setText(PIECE[m_style][KNIGHT][side]);
-                    break;
-                }
-                case 'B':
-                {
-                    m_pieces[r][c]->setText(PIECE[m_style][BISHOP][side]);
-                    break;
-                }
-                case 'Q':
-                {
-                    m_pieces[r][c]->setText(PIECE[m_style][QUEEN][side]);
-                    break;
-                }
-                case 'K':
-                {
-                    m_pieces[r][c]->setText(PIECE[m_style][KING][side]);
-                    break;
-                }
-                default:
-                    m_pieces[r][c]->setText(PIECE_NULL);
-            }
+            Piece* piece = m_board->getPiece(make_pair(ChessBoard::ROW - 1 - r, c));
+            if (!piece)
+                m_pieces[r][c]->setText(PIECE_NULL);
+            else
+                m_pieces[r][c]->setText(PIECE[m_style][piece->getType()][piece->getSide()]);
         }
     }
 
@@ -614,7 +569,7 @@ bool View::load(bool msg)
     m_record->scrollBottom();
 
     // Return if any pawn is going to be promoted.
-    return promoting != 0;
+    return m_board->isPromoting();
 }
 
 void View::restart()
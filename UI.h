@@ -171,7 +171,7 @@ private:
      */
     void selectPiece(int r, int c);
     /**
-     * Load the current status from input stream.
+     * Load the current status from the board, and the messages from the input stream.
      * @param msg: If there is any message in the stream beforehand.
      * @return If there is currently any pawn needed to be promoted.
      */
@@ -213,7 +213,7 @@ public:
     // Symbols for different status of a grid.
     static const int UNSELECTED = 0, SELECTED = 1, FOCUSED = 2;
     // Number of different status of a side(player).
-    static const int STATUS_NUM = 4;
+    static const int STATUS_NUM = 5;
     // Message and style for different status of a side.
     static const std::pair<const char*, int> STATUS[STATUS_NUM];
 